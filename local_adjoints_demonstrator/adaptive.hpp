@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+
+/// Per-tape selection of evaluation kernels by a cost model over cheap tape statistics.
+namespace Adaptive {
+
+  /// Kernels the adaptive strategy chooses from.
+  enum Path {
+    VECTOR_OFFSET = 0,  /// persistent vector with offset, addressed by the original identifiers
+    MAP = 1,            /// persistent open-addressing map
+    EDITING = 2,        /// identifier remapping by radix sort, then temporary vector
+    NUMBER_OF_PATHS = 3
+  };
+
+  inline char const* getPathName(Path path) {
+    static char const* const names[NUMBER_OF_PATHS] = {"persistent vector with offset", "persistent map",
+                                                       "editing with radix sort"};
+    return names[path];
+  }
+
+  /// Statistics of a tape and its evaluations.
+  struct TapeStatistics {
+    public:
+      size_t length;  /// number of tape entries
+      size_t span;    /// maxIdentifier - minIdentifier + 1
+      size_t nSweeps;
+      double unique;  /// estimated number of distinct identifiers
+  };
+
+  /// Collect the statistics in a single pass over the identifiers. Distinct identifiers are estimated by linear
+  /// counting over a bitmap of hashed identifiers.
+  template<typename Identifier, typename TapeType>
+  TapeStatistics computeStatistics(TapeType const& tape, size_t nSweeps) {
+    size_t const bitmapBits = 4096;
+    uint64_t bitmap[bitmapBits / 64] = {};
+
+    Identifier minIdentifier = std::numeric_limits<Identifier>::max();
+    Identifier maxIdentifier = std::numeric_limits<Identifier>::min();
+    for (auto const& identifier : tape.identifiers) {
+      minIdentifier = std::min(minIdentifier, identifier);
+      maxIdentifier = std::max(maxIdentifier, identifier);
+      uint64_t hash = (static_cast<uint64_t>(identifier) * 11400714819323198485ull) >> 52;
+      bitmap[hash / 64] |= uint64_t(1) << (hash % 64);
+    }
+
+    size_t zeroBits = 0;
+    for (uint64_t word : bitmap) {
+      zeroBits += 64 - __builtin_popcountll(word);
+    }
+
+    TapeStatistics statistics;
+    statistics.length = tape.identifiers.size();
+    statistics.span = statistics.length == 0 ? 0 : static_cast<size_t>(maxIdentifier - minIdentifier) + 1;
+    statistics.nSweeps = nSweeps;
+    if (zeroBits == 0) {
+      statistics.unique = static_cast<double>(statistics.length);
+    } else {
+      statistics.unique = -static_cast<double>(bitmapBits) * std::log(static_cast<double>(zeroBits) / bitmapBits);
+    }
+    statistics.unique = std::min(statistics.unique, static_cast<double>(std::min(statistics.length, statistics.span)));
+    return statistics;
+  }
+
+  /** @brief Tunable cost model, costs are relative to an adjoint access in a cache-resident vector.
+   *
+   *  - vector with offset: span * spanCost + length * nSweeps * (vectorCost or missCost if span > cacheSpan)
+   *  - map: length * nSweeps * mapCost
+   *  - editing: length * remapCost + unique * spanCost + length * nSweeps * vectorCost
+   */
+  struct CostModel {
+    public:
+      double spanCost;    /// per adjoint variable in the addressed range
+      double vectorCost;  /// per access in a vector whose range fits into the cache
+      double missCost;    /// per access in a vector whose range exceeds the cache
+      double mapCost;     /// per access in a map
+      double remapCost;   /// per tape entry for remapping
+      double cacheSpan;   /// number of adjoint variables that fit into the cache
+
+      CostModel()
+          : spanCost(0.25), vectorCost(1.0), missCost(4.0), mapCost(6.0), remapCost(2.0), cacheSpan(131072.0) {}
+
+      double estimate(Path path, TapeStatistics const& statistics) const {
+        double accesses = static_cast<double>(statistics.length) * statistics.nSweeps;
+        switch (path) {
+          case VECTOR_OFFSET:
+            return statistics.span * spanCost + accesses * (statistics.span > cacheSpan ? missCost : vectorCost);
+          case MAP:
+            return accesses * mapCost;
+          default:
+            return statistics.length * remapCost + statistics.unique * spanCost + accesses * vectorCost;
+        }
+      }
+
+      /// Path with the smallest estimated cost.
+      Path choose(TapeStatistics const& statistics) const {
+        Path best = VECTOR_OFFSET;
+        for (int path = 1; path < NUMBER_OF_PATHS; ++path) {
+          if (estimate(static_cast<Path>(path), statistics) < estimate(best, statistics)) {
+            best = static_cast<Path>(path);
+          }
+        }
+        return best;
+      }
+  };
+
+  /// Cost model used by the adaptive strategy.
+  inline CostModel& getCostModel() {
+    static CostModel costModel;
+    return costModel;
+  }
+
+  /// Number of tapes per path.
+  struct PathCounts {
+    public:
+      size_t counts[NUMBER_OF_PATHS];
+
+      PathCounts() : counts() {}
+
+      PathCounts& operator+=(PathCounts const& other) {
+        for (int path = 0; path < NUMBER_OF_PATHS; ++path) {
+          counts[path] += other.counts[path];
+        }
+        return *this;
+      }
+  };
+
+  /// Counts of the calling thread since the last flush.
+  inline PathCounts& getLocalCounts() {
+    static PathCounts* localCounts = nullptr;
+    #pragma omp threadprivate(localCounts)
+    if (localCounts == nullptr) {
+      localCounts = new PathCounts();
+    }
+    return *localCounts;
+  }
+
+  /// Flushed counts of all threads.
+  inline PathCounts& getCollectedCounts() {
+    static PathCounts collectedCounts;
+    return collectedCounts;
+  }
+
+  /// Add the counts of the calling thread to the collected counts. Thread-safe.
+  inline void flush() {
+    #pragma omp critical(AdaptiveFlush)
+    {
+      getCollectedCounts() += getLocalCounts();
+    }
+    getLocalCounts() = PathCounts();
+  }
+
+  /// Discard all collected counts, e.g., after warmup runs.
+  inline void reset() {
+    getCollectedCounts() = PathCounts();
+  }
+
+  /// Report the number of tapes per path, averaged over the given number of runs.
+  inline void print(std::ostream& out, PathCounts const& counts, size_t nRuns) {
+    out << "Adaptive strategy, tapes per path per run:" << std::endl;
+    for (int path = 0; path < NUMBER_OF_PATHS; ++path) {
+      out << "  " << getPathName(static_cast<Path>(path)) << ": "
+          << static_cast<double>(counts.counts[path]) / nRuns << std::endl;
+    }
+  }
+}
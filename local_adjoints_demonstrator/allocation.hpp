@@ -0,0 +1,350 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <new>
+#include <ostream>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+/// Allocation of the memory of local adjoint containers.
+namespace Allocation {
+
+  /// Allocator kinds, selected globally before the containers allocate.
+  enum Kind {
+    DEFAULT = 0,                 /// global operator new
+    FIRST_TOUCH = 1,             /// fresh anonymous mapping per allocation, pages touched by the allocating thread
+    TRANSPARENT_HUGE_PAGES = 2,  /// like FIRST_TOUCH, with madvise(MADV_HUGEPAGE)
+    HUGE_PAGES = 3,              /// like FIRST_TOUCH, with explicit huge pages (MAP_HUGETLB), falls back to
+                                 /// TRANSPARENT_HUGE_PAGES if none are available
+  };
+
+  /// Allocator kind used for subsequent allocations.
+  inline Kind& getKind() {
+    static Kind kind = DEFAULT;
+    return kind;
+  }
+
+  size_t const hugePageSize = 2 * 1024 * 1024;
+
+  inline size_t getPageSize() {
+    static size_t const pageSize = sysconf(_SC_PAGESIZE);
+    return pageSize;
+  }
+
+  /// Stored in front of each allocation, so that memory is released correctly even if the kind changes in between.
+  struct Header {
+    public:
+      Kind kind;
+      void* base;     /// start of the underlying allocation
+      size_t length;  /// length of the underlying allocation
+
+      /// Size reserved for the header, keeps the data cache line aligned.
+      static size_t const reservedSize = 64;
+  };
+
+  inline size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+  }
+
+  /// Anonymous private mapping of at least the given length. The pages that cover the given length are touched by the
+  /// calling thread. The huge page kinds use huge pages only for lengths of at least a huge page, so that small allocations
+  /// do not commit a whole huge page each.
+  inline void* map(size_t& length, Kind kind) {
+    size_t requested = length;
+    bool huge = kind != FIRST_TOUCH && length >= hugePageSize;
+    void* base = MAP_FAILED;
+    if (kind == HUGE_PAGES && huge) {
+      size_t hugeLength = roundUp(length, hugePageSize);
+      base = mmap(nullptr, hugeLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (base != MAP_FAILED) {
+        length = hugeLength;
+      }
+    }
+    if (base == MAP_FAILED) {
+      length = roundUp(length, huge ? hugePageSize : getPageSize());
+      base = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      if (huge) {
+        madvise(base, length, MADV_HUGEPAGE);
+      }
+    }
+
+    // first touch, places the pages on the NUMA node of the calling thread
+    for (size_t offset = 0; offset < requested; offset += getPageSize()) {
+      static_cast<volatile char*>(base)[offset] = 0;
+    }
+
+    return base;
+  }
+
+  /// Allocate memory of the given size with the current allocator kind. Mappings are page aligned, allocations of
+  /// the DEFAULT kind are padded so that the header, and thus the data, start at a cache line.
+  inline void* allocate(size_t bytes) {
+    Kind kind = getKind();
+    size_t length = Header::reservedSize + bytes;
+    void* base;
+    char* start;
+    if (kind == DEFAULT) {
+      length += Header::reservedSize - 1;
+      base = ::operator new(length);
+      start = reinterpret_cast<char*>(roundUp(reinterpret_cast<uintptr_t>(base), Header::reservedSize));
+    } else {
+      base = map(length, kind);
+      start = static_cast<char*>(base);
+    }
+
+    Header* header = reinterpret_cast<Header*>(start);
+    header->kind = kind;
+    header->base = base;
+    header->length = length;
+
+    return start + Header::reservedSize;
+  }
+
+  inline void deallocate(void* data) {
+    Header* header = reinterpret_cast<Header*>(static_cast<char*>(data) - Header::reservedSize);
+    if (header->kind == DEFAULT) {
+      ::operator delete(header->base);
+    } else {
+      munmap(header->base, header->length);
+    }
+  }
+
+  /// Standard allocator interface to the current allocator kind.
+  template<typename T>
+  struct Allocator {
+    public:
+      using value_type = T;
+
+      Allocator() {}
+
+      template<typename U>
+      Allocator(Allocator<U> const&) {}
+
+      T* allocate(size_t n) {
+        return static_cast<T*>(Allocation::allocate(n * sizeof(T)));
+      }
+
+      void deallocate(T* pointer, size_t) {
+        Allocation::deallocate(pointer);
+      }
+  };
+
+  template<typename T, typename U>
+  bool operator==(Allocator<T> const&, Allocator<U> const&) {
+    return true;
+  }
+
+  template<typename T, typename U>
+  bool operator!=(Allocator<T> const&, Allocator<U> const&) {
+    return false;
+  }
+
+  /** @brief Thread-local monotonic arena for the nodes of temporary maps.
+   *
+   *  Memory is handed out from chunks of growing size and never freed individually. A reset rewinds to the first chunk
+   *  and keeps all chunks for reuse, release returns them to the system.
+   */
+  struct Arena {
+    public:
+      struct Chunk {
+        public:
+          char* data;
+          size_t size;
+      };
+
+      static size_t const minChunkSize = 64 * 1024;
+
+      std::vector<Chunk> chunks;
+      size_t current;  /// index of the chunk in use, chunks.size() if none is in use
+      char* position;
+      char* end;
+
+      Arena() : chunks(), current(0), position(nullptr), end(nullptr) {}
+
+      void* allocate(size_t bytes, size_t alignment) {
+        char* aligned = alignUp(position, alignment);
+        while (aligned == nullptr || aligned + bytes > end) {
+          nextChunk(bytes + alignment);
+          aligned = alignUp(position, alignment);
+        }
+        position = aligned + bytes;
+        return aligned;
+      }
+
+      /// Make all memory available again, to be called once nothing allocated from the arena is in use.
+      void reset() {
+        current = chunks.size();
+        position = nullptr;
+        end = nullptr;
+        if (!chunks.empty()) {
+          use(0);
+        }
+      }
+
+      void release() {
+        for (auto const& chunk : chunks) {
+          ::operator delete(chunk.data);
+        }
+        *this = Arena();
+      }
+
+    private:
+      static char* alignUp(char* pointer, size_t alignment) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(pointer);
+        return reinterpret_cast<char*>((address + alignment - 1) / alignment * alignment);
+      }
+
+      void use(size_t chunk) {
+        current = chunk;
+        position = chunks[chunk].data;
+        end = chunks[chunk].data + chunks[chunk].size;
+      }
+
+      /// Continue with the next chunk of at least the given size, allocate a new one if there is none.
+      void nextChunk(size_t bytes) {
+        for (size_t chunk = (position == nullptr ? 0 : current + 1); chunk < chunks.size(); ++chunk) {
+          if (chunks[chunk].size >= bytes) {
+            use(chunk);
+            return;
+          }
+        }
+
+        size_t size = std::max(bytes, chunks.empty() ? minChunkSize : 2 * chunks.back().size);
+        Chunk chunk = {static_cast<char*>(::operator new(size)), size};
+        chunks.push_back(chunk);
+        use(chunks.size() - 1);
+      }
+  };
+
+  /// Arena of the calling thread.
+  inline Arena& getLocalArena() {
+    static Arena* arena = nullptr;
+    #pragma omp threadprivate(arena)
+    if (arena == nullptr) {
+      arena = new Arena();
+    }
+    return *arena;
+  }
+
+  /// Resets the arena of the calling thread at the end of its lifetime. Declare before the containers that allocate
+  /// from the arena, so that they are destructed first.
+  struct ArenaScope {
+    public:
+      ArenaScope() {}
+
+      ~ArenaScope() {
+        getLocalArena().reset();
+      }
+  };
+
+  /// Standard allocator interface to the arena of the calling thread. Deallocation is a no-op.
+  template<typename T>
+  struct ArenaAllocator {
+    public:
+      using value_type = T;
+
+      ArenaAllocator() {}
+
+      template<typename U>
+      ArenaAllocator(ArenaAllocator<U> const&) {}
+
+      T* allocate(size_t n) {
+        return static_cast<T*>(getLocalArena().allocate(n * sizeof(T), alignof(T)));
+      }
+
+      void deallocate(T*, size_t) {}
+  };
+
+  template<typename T, typename U>
+  bool operator==(ArenaAllocator<T> const&, ArenaAllocator<U> const&) {
+    return true;
+  }
+
+  template<typename T, typename U>
+  bool operator!=(ArenaAllocator<T> const&, ArenaAllocator<U> const&) {
+    return false;
+  }
+
+  /// Number of pages per NUMA node, node -1 for pages whose node could not be determined.
+  using Placement = std::map<int, size_t>;
+
+  /// Whether recordPlacement records anything, disabled by default as querying pages is costly.
+  inline bool& getPlacementEnabled() {
+    static bool enabled = false;
+    return enabled;
+  }
+
+  /// Placement recorded from all threads since the last reset.
+  inline Placement& getRecordedPlacement() {
+    static Placement placement;
+    return placement;
+  }
+
+  /// Query the NUMA nodes of the pages of the given memory via move_pages.
+  inline void queryPlacement(void const* data, size_t bytes, Placement& placement) {
+    if (bytes == 0) {
+      return;
+    }
+
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data) / getPageSize() * getPageSize();
+    uintptr_t end = reinterpret_cast<uintptr_t>(data) + bytes;
+    std::vector<void*> pages;
+    for (uintptr_t page = begin; page < end; page += getPageSize()) {
+      pages.push_back(reinterpret_cast<void*>(page));
+    }
+
+    std::vector<int> status(pages.size(), -1);
+    #ifdef SYS_move_pages
+      if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0) {
+        status.assign(pages.size(), -1);
+      }
+    #endif
+
+    for (int node : status) {
+      ++placement[node < 0 ? -1 : node];
+    }
+  }
+
+  /// Record the placement of the given memory if enabled. Thread-safe.
+  inline void recordPlacement(void const* data, size_t bytes) {
+    if (!getPlacementEnabled()) {
+      return;
+    }
+
+    Placement placement;
+    queryPlacement(data, bytes, placement);
+
+    #pragma omp critical(AllocationPlacement)
+    {
+      for (auto const& node : placement) {
+        getRecordedPlacement()[node.first] += node.second;
+      }
+    }
+  }
+
+  inline void resetPlacement() {
+    getRecordedPlacement().clear();
+  }
+
+  /// Report pages per node, averaged over the given number of runs.
+  inline void printPlacement(std::ostream& out, Placement const& placement, size_t nRuns) {
+    out << "Pages of persistent adjoint vectors per NUMA node per run:" << std::endl;
+    for (auto const& node : placement) {
+      if (node.first < 0) {
+        out << "  unknown: ";
+      } else {
+        out << "  node " << node.first << ": ";
+      }
+      out << static_cast<double>(node.second) / nRuns << std::endl;
+    }
+  }
+}
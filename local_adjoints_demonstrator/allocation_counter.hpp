@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <omp.h>
+#include <ostream>
+#include <vector>
+
+/** @brief Optional per-thread counting of heap allocations.
+ *
+ *  Compiled in only if LOCAL_ADJOINTS_COUNT_ALLOCATIONS is defined, in which case the global operator new and operator
+ *  delete are replaced. As replacements must be defined once per program, this header may only be included by a single
+ *  translation unit, which holds for the benchmark and test executables.
+ */
+namespace AllocationCounter {
+
+  /// Number and total size of allocations.
+  struct Counts {
+    public:
+      size_t count;
+      size_t bytes;
+  };
+
+  /// Counts of the calling thread.
+  inline Counts& getLocalCounts() {
+    static Counts localCounts = {0, 0};
+    #pragma omp threadprivate(localCounts)
+    return localCounts;
+  }
+
+  constexpr bool isEnabled() {
+    #ifdef LOCAL_ADJOINTS_COUNT_ALLOCATIONS
+      return true;
+    #else
+      return false;
+    #endif
+  }
+
+  /// Reset the counts of all threads of the default team.
+  inline void reset() {
+    #pragma omp parallel
+    {
+      getLocalCounts() = Counts{0, 0};
+    }
+  }
+
+  /// Counts of all threads of the default team, indexed by OpenMP thread number.
+  inline std::vector<Counts> collect() {
+    std::vector<Counts> counts(omp_get_max_threads(), Counts{0, 0});
+    #pragma omp parallel
+    {
+      counts[omp_get_thread_num()] = getLocalCounts();
+    }
+    return counts;
+  }
+
+  /// Report allocations per thread, averaged over the given number of runs.
+  inline void print(std::ostream& out, std::vector<Counts> const& counts, size_t nRuns) {
+    out << "Allocations per run:" << std::endl;
+    out << std::setw(12) << "thread" << std::setw(16) << "count" << std::setw(16) << "bytes" << std::endl;
+    for (size_t thread = 0; thread < counts.size(); ++thread) {
+      out << std::setw(12) << thread << std::setw(16) << static_cast<double>(counts[thread].count) / nRuns
+          << std::setw(16) << static_cast<double>(counts[thread].bytes) / nRuns << std::endl;
+    }
+  }
+}
+
+#ifdef LOCAL_ADJOINTS_COUNT_ALLOCATIONS
+  void* operator new(size_t size) {
+    AllocationCounter::Counts& counts = AllocationCounter::getLocalCounts();
+    ++counts.count;
+    counts.bytes += size;
+
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+      throw std::bad_alloc();
+    }
+    return pointer;
+  }
+
+  void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+  }
+#endif
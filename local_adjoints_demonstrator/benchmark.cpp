@@ -1,87 +1,853 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
 #include "benchmark.hpp"
 
+void printUsage() {
+  std::cout << "Usage: ./benchmark nPreaccs preaccSizeMin preaccSizeMax nEvalMin nEvalMax iMin iMax nWarmups nRuns"
+            << " strategy [randomSeed] [--option=value ...]" << std::endl << std::endl;
+  std::cout << "nPreaccs: number of preaccumulations" << std::endl;
+  std::cout << "preaccSizeMin: minimum size of preaccumulations" << std::endl;
+  std::cout << "preaccSizeMax: maximum size of preaccumulations" << std::endl;
+  std::cout << "nEvalMin: minimum number of evaluations per preaccumulation" << std::endl;
+  std::cout << "nEvalMax: maximum number of evaluations per preaccumulation" << std::endl;
+  std::cout << "iMin: minimum identifier" << std::endl;
+  std::cout << "iMax: maximum identifier" << std::endl;
+  std::cout << "nWarmups: number of discarded warmup runs" << std::endl;
+  std::cout << "nRuns: number of benchmark runs" << std::endl;
+  std::cout << "strategy:" << std::endl;
+  std::cout << "  0: temporary vector" << std::endl;
+  std::cout << "  1: persistent vector" << std::endl;
+  std::cout << "  2: persistent vector with offset" << std::endl;
+  std::cout << "  3: temporary map, std::map" << std::endl;
+  std::cout << "  4: temporary map, std::unordered_map" << std::endl;
+  std::cout << "  5: editing with std::map, temporary vector" << std::endl;
+  std::cout << "  6: editing with std::unordered_map, temporary vector" << std::endl;
+  std::cout << "  7: persistent map, open addressing" << std::endl;
+  std::cout << "  8: persistent vector with epochs, no zeroing" << std::endl;
+  std::cout << "  9: editing with std::map, compact tape, temporary vector" << std::endl;
+  std::cout << " 10: editing with std::unordered_map, compact tape, temporary vector" << std::endl;
+  std::cout << " 11: editing with radix sort, temporary vector" << std::endl;
+  std::cout << " 12: editing with open addressing map, temporary vector" << std::endl;
+  std::cout << " 13: persistent vector in reserved virtual memory" << std::endl;
+  std::cout << " 14: adaptive, per tape one of 2, 7, 11 by a cost model" << std::endl;
+  std::cout << " 15: temporary map, std::map, arena allocator" << std::endl;
+  std::cout << " 16: temporary map, std::unordered_map, arena allocator" << std::endl;
+  std::cout << " 17: editing with std::map, arena allocator, temporary vector" << std::endl;
+  std::cout << " 18: editing with std::unordered_map, arena allocator, temporary vector" << std::endl;
+  std::cout << " 19: persistent paged vector, pages allocated on first touch" << std::endl;
+  std::cout << "randomSeed: specify a random seed, defaults to 42, generated workload is deterministic w.r.t. this seed"
+            << std::endl << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --identifier=t: identifier type, one of int32 (default), int64, uint32, uint64; the largest value of"
+            << " the type is reserved, so iMax has to be smaller" << std::endl;
+  std::cout << "  --gradient=t: gradient type, one of float, double (default)" << std::endl;
+  std::cout << "  --vector-width=w: number of seeds propagated per tape evaluation, one of 1 (scalar mode, default), 4, 8,"
+            << " 16" << std::endl;
+  std::cout << "  --pregenerate: generate the workload once before all runs, runtimes exclude the generation" << std::endl;
+  std::cout << "  --keep-remapped: with --pregenerate, editing strategies remap stored tapes in place, later runs reuse"
+            << " them" << std::endl;
+  std::cout << "  --schedule=s: distribution of work items across threads, one of static (default), dynamic, guided,"
+            << " cost (longest estimated cost first with work stealing)" << std::endl;
+  std::cout << "  --chunk-size=c: chunk size of the static, dynamic and guided schedules, defaults to the OpenMP default"
+            << std::endl;
+  std::cout << "  --allocator=a: memory of persistent vectors (strategies 1, 2, 8), one of default (operator new),"
+            << " first-touch (fresh mapping touched by the owning thread), thp (additionally transparent huge pages),"
+            << " hugetlb (explicit huge pages, falls back to thp)" << std::endl;
+  std::cout << "  --placement: report the pages of persistent vectors (strategies 1, 2, 8, 13) per NUMA node"
+            << std::endl;
+  std::cout << "  --memory: report the high water mark of the benchmark runs, the resident memory before the runs,"
+            << " and the peak bytes of local adjoints per thread and container" << std::endl;
+  std::cout << "  --memory-samples=ms: with --memory, also sample the resident set size every ms milliseconds on a"
+            << " background thread" << std::endl;
+  std::cout << "  --counters: report hardware performance counters of the benchmark runs via perf_event_open, events"
+            << " that are unavailable are reported as such" << std::endl;
+  std::cout << "  --identifiers=m: distribution of generated identifiers, one of uniform (default),"
+            << " clustered[:window,jump] (near a cursor that advances per entry and jumps with probability jump,"
+            << " defaults 256,0.01), zipf[:exponent] (Zipf-distributed reuse, default 1),"
+            << " shared[:group,set,fraction] (groups of neighbouring work items draw the given fraction of identifiers"
+            << " from a common set, defaults 8,1024,0.5)" << std::endl;
+  std::cout << "  --statements[=i,o,a,w]: generate statement tapes with i inputs, o outputs, 1 to a arguments per"
+            << " statement drawn from the last w variables or any with equal probability, defaults 4,4,2,8;"
+            << " preaccSize is the number of statements" << std::endl;
+  std::cout << "  --mode=m: direction of the sweeps, one of reverse (default, one sweep per evaluation, i.e., output),"
+            << " forward (one sweep per input), automatic (per work item the direction with fewer sweeps)" << std::endl;
+  std::cout << "  --inputs=min,max: range of the number of inputs per work item, defaults to nEvalMin,nEvalMax"
+            << std::endl;
+  std::cout << "  --split=c: split the seeds of work items whose tape size times number of seeds exceeds c into OpenMP"
+            << " tasks of about cost c each, 0 (default) never splits" << std::endl;
+  std::cout << "  --prefetch=d1,d2,...: prefetch the adjoint variables of tape entries d ahead, 0 (default) disables"
+            << " prefetching; several distances run a sweep" << std::endl;
+  std::cout << "  --global-tape=g: store the result of each work item in a shared global tape, one of none (default),"
+            << " lock (global lock), atomic (atomic bump allocation in chunks), segments (per-thread segments merged"
+            << " after all work items)" << std::endl;
+  std::cout << "  --record=file: write the generated workload to a trace file and exit" << std::endl;
+  std::cout << "  --replay=file: evaluate the work items of a trace file in place instead of generating them, the"
+            << " workload arguments are ignored" << std::endl;
+  std::cout << "  --stream: with --replay, read work items ahead and drop processed ones, for traces larger than the main"
+            << " memory" << std::endl;
+  std::cout << "  --adaptive-costs=c1,c2,...: cost model of strategy 14, relative costs spanCost, vectorCost, missCost,"
+            << " mapCost, remapCost and the cache size cacheSpan in adjoint variables, see adaptive.hpp" << std::endl
+            << std::endl;
+  std::cout << "Sweep options, each configuration runs in a forked process, results are written as CSV or JSON:"
+            << std::endl;
+  std::cout << "  --strategies=s1,s2,...: strategies to run, replaces strategy" << std::endl;
+  std::cout << "  --threads=t1,t2,...: numbers of threads to run with, defaults to the OpenMP default" << std::endl;
+  std::cout << "  --workloads=w1/w2/...: workloads of the form nPreaccs,preaccSizeMin,preaccSizeMax,nEvalMin,nEvalMax,"
+            << "iMin,iMax, replace the corresponding arguments" << std::endl;
+  std::cout << "  --format=f: csv (default) or json, also selects sweep mode for a single configuration" << std::endl;
+  std::cout << "  --output=file: write results to file instead of standard output" << std::endl << std::endl;
+  std::cout << "Output: [strategy] [number of threads] [nWarmups] [nRuns] [average time] [minimum time] "
+               "[maximum time] [memory hwm] [checksum] [load imbalance]" << std::endl << std::endl;
+  std::cout << "Set number of threads by setting OMP_NUM_THREADS." << std::endl;
+  std::cout << "Build with -DLOCAL_ADJOINTS_INSTRUMENTATION to additionally report per-phase and per-thread times."
+            << std::endl;
+  std::cout << "Build with -DLOCAL_ADJOINTS_COUNT_ALLOCATIONS to additionally report per-thread heap allocations."
+            << std::endl;
+  std::cout << "Build with -DLOCAL_ADJOINTS_ALL_TYPES, e.g., via make benchmark-all-types, to instantiate all"
+            << " identifier and gradient types, otherwise only int32 identifiers and double gradients are supported."
+            << std::endl;
+}
+
+/// Remove an option from the parsed options and return its value, or the default value if it was not specified.
+std::string takeOption(std::map<std::string, std::string>& options, std::string const& name,
+                       std::string const& defaultValue) {
+  auto option = options.find(name);
+  if (option == options.end()) {
+    return defaultValue;
+  }
+  std::string value = option->second;
+  options.erase(option);
+  return value;
+}
+
+/// Remove a flag from the parsed options and return whether it was specified.
+bool takeFlag(std::map<std::string, std::string>& options, std::string const& name) {
+  return options.count(name) != 0 && takeOption(options, name, "") != "0";
+}
+
+/// Parse the name of a schedule, returns false for unknown names.
+bool parseSchedule(std::string const& name, Scheduling::Schedule& schedule) {
+  if (name == "static") {
+    schedule = Scheduling::STATIC;
+  } else if (name == "dynamic") {
+    schedule = Scheduling::DYNAMIC;
+  } else if (name == "guided") {
+    schedule = Scheduling::GUIDED;
+  } else if (name == "cost") {
+    schedule = Scheduling::COST_MODEL;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// Parse the name of an allocator kind, returns false for unknown names.
+bool parseAllocator(std::string const& name, Allocation::Kind& kind) {
+  if (name == "default") {
+    kind = Allocation::DEFAULT;
+  } else if (name == "first-touch") {
+    kind = Allocation::FIRST_TOUCH;
+  } else if (name == "thp") {
+    kind = Allocation::TRANSPARENT_HUGE_PAGES;
+  } else if (name == "hugetlb") {
+    kind = Allocation::HUGE_PAGES;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// Parse the name of a mode, returns false for unknown names.
+bool parseMode(std::string const& name, EvaluationStrategy::Mode& mode) {
+  for (int candidate = EvaluationStrategy::REVERSE; candidate <= EvaluationStrategy::AUTOMATIC; ++candidate) {
+    if (name == EvaluationStrategy::getModeName(static_cast<EvaluationStrategy::Mode>(candidate))) {
+      mode = static_cast<EvaluationStrategy::Mode>(candidate);
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Parse the name of a global tape scheme, returns false for unknown names.
+bool parseGlobalTapeScheme(std::string const& name, GlobalTape::Scheme& scheme) {
+  for (int candidate = GlobalTape::NONE; candidate <= GlobalTape::SEGMENTS; ++candidate) {
+    if (name == GlobalTape::getSchemeName(static_cast<GlobalTape::Scheme>(candidate))) {
+      scheme = static_cast<GlobalTape::Scheme>(candidate);
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Parse a comma-separated list of cost model parameters, returns false if the number of values does not match.
+bool parseCostModel(std::string const& list, Adaptive::CostModel& costModel) {
+  double* parameters[] = {&costModel.spanCost, &costModel.vectorCost, &costModel.missCost, &costModel.mapCost,
+                          &costModel.remapCost, &costModel.cacheSpan};
+  size_t const nParameters = sizeof(parameters) / sizeof(parameters[0]);
+
+  size_t position = 0;
+  for (size_t i = 0; i < nParameters; ++i) {
+    size_t separator = list.find(',', position);
+    if ((separator == std::string::npos) != (i == nParameters - 1)) {
+      return false;
+    }
+    *parameters[i] = std::stod(list.substr(position, separator - position));
+    position = separator + 1;
+  }
+  return true;
+}
+
+/// Parse an identifier model of the form name[:p1,p2,...], omitted parameters keep their defaults.
+bool parseIdentifierModel(std::string const& text, Generators::Parameters& parameters) {
+  size_t colon = text.find(':');
+  std::string name = text.substr(0, colon);
+  std::vector<double> values;
+  if (colon != std::string::npos) {
+    std::stringstream stream(text.substr(colon + 1));
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+      values.push_back(std::stod(value));
+    }
+  }
+
+  if (name == "uniform" && values.empty()) {
+    parameters.model = Generators::UNIFORM;
+  } else if (name == "clustered" && values.size() <= 2) {
+    parameters.model = Generators::CLUSTERED;
+    parameters.windowSize = values.size() > 0 ? static_cast<size_t>(values[0]) : parameters.windowSize;
+    parameters.jumpProbability = values.size() > 1 ? values[1] : parameters.jumpProbability;
+  } else if (name == "zipf" && values.size() <= 1) {
+    parameters.model = Generators::ZIPF;
+    parameters.zipfExponent = values.size() > 0 ? values[0] : parameters.zipfExponent;
+  } else if (name == "shared" && values.size() <= 3) {
+    parameters.model = Generators::SHARED;
+    parameters.groupSize = values.size() > 0 ? static_cast<size_t>(values[0]) : parameters.groupSize;
+    parameters.sharedSetSize = values.size() > 1 ? static_cast<size_t>(values[1]) : parameters.sharedSetSize;
+    parameters.sharedFraction = values.size() > 2 ? values[2] : parameters.sharedFraction;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// Parameters of a generated workload, in the order of the command line arguments.
+struct WorkloadParameters {
+  public:
+    size_t nPreaccs;
+    size_t preaccSizeMin;
+    size_t preaccSizeMax;
+    size_t nEvalMin;
+    size_t nEvalMax;
+    size_t iMin;
+    size_t iMax;
+};
+
+/// Options that apply to the preaccumulations of all configurations.
+struct PreaccumulationOptions {
+  public:
+    size_t randomSeed;
+    size_t vectorWidth;
+    bool pregenerate;
+    bool keepRemapped;
+    Scheduling::Schedule schedule;
+    size_t chunkSize;
+    std::string replayPath;                  /// trace to replay instead of generating the workload, empty for none
+    bool stream;                             /// replay with readahead hints and drop-behind
+    Generators::Parameters identifierModel;  /// distribution of the identifiers of generated tapes
+    bool statementTapes;                     /// generate statement tapes instead of chains
+    StatementShape statementShape;           /// shape of generated statement tapes
+    GlobalTape::Scheme globalTapeScheme;     /// how results are stored in the global tape
+    EvaluationStrategy::Mode mode;           /// direction of the sweeps
+    std::vector<size_t> inputs;              /// range of the number of inputs per work item, empty for the default
+    double splitThreshold;                   /// cost above which work items are split into tasks, 0 never
+    std::string identifierType;              /// name of the identifier type, see getTypeName
+    std::string gradientType;                /// name of the gradient type, see getTypeName
+};
+
+/// Parse a list of non-negative integers with the given separator.
+std::vector<size_t> parseList(std::string const& list, char separator) {
+  std::vector<size_t> values;
+  std::stringstream stream(list);
+  std::string value;
+  while (std::getline(stream, value, separator)) {
+    values.push_back(std::stol(value));
+  }
+  return values;
+}
+
+/// Parse workloads separated by '/', returns false if a workload does not consist of seven values.
+bool parseWorkloads(std::string const& list, std::vector<WorkloadParameters>& workloads) {
+  std::stringstream stream(list);
+  std::string workload;
+  while (std::getline(stream, workload, '/')) {
+    std::vector<size_t> values = parseList(workload, ',');
+    if (values.size() != 7) {
+      return false;
+    }
+    workloads.push_back({values[0], values[1], values[2], values[3], values[4], values[5], values[6]});
+  }
+  return true;
+}
+
+/// Parse a statement shape of the form [nInputs[,nOutputs[,maxArguments[,window]]]], omitted values keep their defaults.
+bool parseStatementShape(std::string const& text, StatementShape& shape) {
+  size_t* values[] = {&shape.nInputs, &shape.nOutputs, &shape.maxArguments, &shape.window};
+  std::vector<size_t> list = parseList(text, ',');
+  if (list.size() > 4) {
+    return false;
+  }
+  for (size_t i = 0; i < list.size(); ++i) {
+    *values[i] = list[i];
+  }
+  return shape.nInputs > 0 && shape.maxArguments > 0 && shape.maxArguments <= 255;
+}
+
+/// Create the preaccumulations of the given workload. Throws std::invalid_argument if the identifier range does not
+/// fit into the identifier type, whose largest value is reserved, and std::runtime_error if a trace cannot be read.
+template<typename Identifier, typename Gradient>
+Preaccumulations<Identifier, Gradient> createPreaccumulations(WorkloadParameters const& workload,
+                                                              PreaccumulationOptions const& options) {
+  if (workload.iMin > workload.iMax ||
+      static_cast<uint64_t>(workload.iMax) >= static_cast<uint64_t>(std::numeric_limits<Identifier>::max())) {
+    throw std::invalid_argument("Identifiers [" + std::to_string(workload.iMin) + ", " + std::to_string(workload.iMax) +
+                                "] do not fit into " + getTypeName<Identifier>() + ".");
+  }
+  Preaccumulations<Identifier, Gradient> preaccs(workload.nPreaccs, workload.preaccSizeMin, workload.preaccSizeMax,
+                                                 workload.nEvalMin, workload.nEvalMax, workload.iMin, workload.iMax,
+                                                 options.randomSeed);
+  preaccs.vectorWidth = options.vectorWidth;
+  preaccs.keepRemapped = options.keepRemapped;
+  preaccs.schedule = options.schedule;
+  preaccs.chunkSize = options.chunkSize;
+  preaccs.identifierModel = options.identifierModel;
+  preaccs.statementTapes = options.statementTapes;
+  preaccs.statementShape = options.statementShape;
+  preaccs.globalTape.scheme = options.globalTapeScheme;
+  preaccs.mode = options.mode;
+  preaccs.splitThreshold = options.splitThreshold;
+  if (!options.replayPath.empty()) {
+    preaccs.replay(options.replayPath, options.stream);
+  } else if (options.pregenerate) {
+    preaccs.pregenerate();
+  }
+  if (!options.inputs.empty()) {
+    preaccs.nInputsMin = options.inputs[0];
+    preaccs.nInputsMax = options.inputs[1];
+  }
+  return preaccs;
+}
+
+template<typename Identifier, typename Gradient>
+using StrategyRunner = PerformanceData<Gradient> (*)(Benchmark<Identifier, Gradient>&,
+                                                     Preaccumulations<Identifier, Gradient>&);
+
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
+PerformanceData<Gradient> runStrategy(Benchmark<Identifier, Gradient>& benchmark,
+                                      Preaccumulations<Identifier, Gradient>& preaccs) {
+  return benchmark.template run<strategy>(preaccs);
+}
+
+/// Runners of all strategies for the given types, indexed by strategy number.
+template<typename Identifier, typename Gradient>
+struct StrategyTable {
+  public:
+    static StrategyRunner<Identifier, Gradient> const runners[];
+    static size_t const size;
+};
+
+template<typename Identifier, typename Gradient>
+StrategyRunner<Identifier, Gradient> const StrategyTable<Identifier, Gradient>::runners[] = {
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_VECTOR>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_VECTOR>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_VECTOR_OFFSET>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_MAP>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_UNORDERED_MAP>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_MAP_EDITING>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_UNORDERED_MAP_EDITING>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_FLAT_MAP>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_EPOCH_VECTOR>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_MAP_EDITING_COMPACT>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::RADIX_SORT_EDITING>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::FLAT_MAP_EDITING>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_RESERVED_VECTOR>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::ADAPTIVE>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_MAP_ARENA>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_UNORDERED_MAP_ARENA>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_MAP_EDITING_ARENA>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>,
+    &runStrategy<Identifier, Gradient, EvaluationStrategy::PERSISTENT_PAGED_VECTOR>};
+
+template<typename Identifier, typename Gradient>
+size_t const StrategyTable<Identifier, Gradient>::size =
+    sizeof(StrategyTable<Identifier, Gradient>::runners) / sizeof(StrategyTable<Identifier, Gradient>::runners[0]);
+
+/// Benchmark the given strategy, returns false for unknown strategies.
+template<typename Identifier, typename Gradient>
+bool runStrategy(size_t strategy, Benchmark<Identifier, Gradient>& benchmark,
+                 Preaccumulations<Identifier, Gradient>& preaccs, PerformanceData<Gradient>& data) {
+  if (strategy >= StrategyTable<Identifier, Gradient>::size) {
+    return false;
+  }
+  data = StrategyTable<Identifier, Gradient>::runners[strategy](benchmark, preaccs);
+  return true;
+}
+
+/// Whether the benchmark is instantiated for the identifier and gradient types of the given names.
+bool isSupportedType(std::string const& identifierType, std::string const& gradientType) {
+  bool identifierSupported = identifierType == getTypeName<int32_t>();
+  bool gradientSupported = gradientType == getTypeName<double>();
+#ifdef LOCAL_ADJOINTS_ALL_TYPES
+  identifierSupported = identifierSupported || identifierType == getTypeName<int64_t>() ||
+                        identifierType == getTypeName<uint32_t>() || identifierType == getTypeName<uint64_t>();
+  gradientSupported = gradientSupported || gradientType == getTypeName<float>();
+#endif
+  return identifierSupported && gradientSupported;
+}
+
+template<typename Identifier, typename Visitor>
+auto dispatchGradient(std::string const& gradientType, Visitor const& visitor)
+    -> decltype(visitor.template run<Identifier, double>()) {
+#ifdef LOCAL_ADJOINTS_ALL_TYPES
+  if (gradientType == getTypeName<float>()) {
+    return visitor.template run<Identifier, float>();
+  }
+#else
+  (void)gradientType;
+#endif
+  return visitor.template run<Identifier, double>();
+}
+
+/// Call visitor.run<Identifier, Gradient>() with the types selected in the options, which have to be supported. All
+/// combinations are instantiated at compile time if built with -DLOCAL_ADJOINTS_ALL_TYPES, otherwise only the
+/// default types.
+template<typename Visitor>
+auto dispatchTypes(PreaccumulationOptions const& options, Visitor const& visitor)
+    -> decltype(visitor.template run<int32_t, double>()) {
+#ifdef LOCAL_ADJOINTS_ALL_TYPES
+  if (options.identifierType == getTypeName<int64_t>()) {
+    return dispatchGradient<int64_t>(options.gradientType, visitor);
+  } else if (options.identifierType == getTypeName<uint32_t>()) {
+    return dispatchGradient<uint32_t>(options.gradientType, visitor);
+  } else if (options.identifierType == getTypeName<uint64_t>()) {
+    return dispatchGradient<uint64_t>(options.gradientType, visitor);
+  }
+#endif
+  return dispatchGradient<int32_t>(options.gradientType, visitor);
+}
+
+/// Benchmark one configuration of a sweep and format the result as a record. Throws std::invalid_argument for unknown
+/// strategies.
+struct RecordRun {
+  public:
+    size_t strategy;
+    WorkloadParameters const& workload;
+    PreaccumulationOptions const& options;
+    size_t nWarmups;
+    size_t nRuns;
+    bool json;
+
+    template<typename Identifier, typename Gradient>
+    std::string run() const {
+      auto preaccs = createPreaccumulations<Identifier, Gradient>(workload, options);
+      Benchmark<Identifier, Gradient> benchmark(nWarmups, nRuns);
+      PerformanceData<Gradient> data;
+      if (!runStrategy(strategy, benchmark, preaccs, data)) {
+        throw std::invalid_argument("Unknown strategy " + std::to_string(strategy) + ".");
+      }
+
+      std::ostringstream record;
+      if (json) {
+        writeJson(record, strategy, preaccs, data);
+      } else {
+        writeCsv(record, strategy, preaccs, data);
+      }
+      return record.str();
+    }
+};
+
+/// Run one configuration of a sweep in a forked process, so that its memory high water mark is not affected by other
+/// configurations. Returns the formatted result, or an empty string if the configuration failed.
+std::string runInChild(size_t strategy, size_t nThreads, WorkloadParameters const& workload,
+                       PreaccumulationOptions const& options, size_t nWarmups, size_t nRuns, bool json) {
+  int pipeDescriptors[2];
+  if (pipe(pipeDescriptors) != 0) {
+    return "";
+  }
+
+  std::cout.flush();
+  pid_t child = fork();
+  if (child < 0) {
+    close(pipeDescriptors[0]);
+    close(pipeDescriptors[1]);
+    return "";
+  }
+
+  if (child == 0) {
+    close(pipeDescriptors[0]);
+    omp_set_num_threads(nThreads);
+
+    std::string text;
+    try {
+      text = dispatchTypes(options, RecordRun{strategy, workload, options, nWarmups, nRuns, json});
+    } catch (std::exception const& error) {
+      std::cerr << error.what() << std::endl;
+      _exit(1);
+    }
+    size_t written = 0;
+    while (written < text.size()) {
+      ssize_t count = write(pipeDescriptors[1], text.data() + written, text.size() - written);
+      if (count <= 0) {
+        _exit(1);
+      }
+      written += count;
+    }
+    _exit(0);
+  }
+
+  close(pipeDescriptors[1]);
+  std::string result;
+  char buffer[4096];
+  ssize_t count;
+  while ((count = read(pipeDescriptors[0], buffer, sizeof(buffer))) > 0) {
+    result.append(buffer, count);
+  }
+  close(pipeDescriptors[0]);
+
+  int status;
+  waitpid(child, &status, 0);
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    return "";
+  }
+  return result;
+}
+
+/// Benchmark a single configuration and print the results, returns the exit code.
+struct SingleRun {
+  public:
+    size_t strategy;
+    WorkloadParameters const& workload;
+    PreaccumulationOptions const& options;
+    size_t nWarmups;
+    size_t nRuns;
+    std::string const& recordPath;
+    bool placement;
+    bool counters;
+    bool memory;
+
+    template<typename Identifier, typename Gradient>
+    int run() const {
+      Preaccumulations<Identifier, Gradient> preaccs(0, 0, 0, 0, 0, 0, 0, 0);
+      try {
+        preaccs = createPreaccumulations<Identifier, Gradient>(workload, options);
+        if (!recordPath.empty()) {
+          preaccs.record(recordPath);
+          std::cout << "Recorded " << preaccs.nPreaccs << " work items to " << recordPath << "." << std::endl;
+          return 0;
+        }
+      } catch (std::exception const& error) {
+        std::cout << error.what() << std::endl;
+        return 1;
+      }
+      Benchmark<Identifier, Gradient> benchmark(nWarmups, nRuns);
+
+      PerformanceData<Gradient> data;
+      if (!runStrategy(strategy, benchmark, preaccs, data)) {
+        std::cout << "Unknown strategy " << strategy << "." << std::endl << std::endl;
+        printUsage();
+        return 1;
+      }
+
+      std::cout << std::setw(5) << strategy << data << std::endl;
+
+      if (Instrumentation::isEnabled()) {
+        Instrumentation::print(std::cout, data.threadTimes, nRuns);
+      }
+
+      if (placement) {
+        Allocation::printPlacement(std::cout, data.placement, nRuns);
+      }
+
+      if (AllocationCounter::isEnabled()) {
+        AllocationCounter::print(std::cout, data.allocations, nRuns);
+      }
+
+      if (memory) {
+        std::cout << "High water mark "
+                  << (data.memoryHwmReset ? "of the benchmark runs" : "of the process, reset is not supported") << ": "
+                  << data.memoryHwm << " MB, resident before the benchmark runs: " << data.memoryBase << " MB"
+                  << std::endl;
+        Memory::print(std::cout, data.adjointPeaks, data.rssSamples);
+      }
+
+      if (preaccs.mode != EvaluationStrategy::REVERSE) {
+        std::cout << "Work items in forward mode per run: " << data.forwardItemsAvg << " of " << preaccs.nPreaccs
+                  << ", swept tape entries saved compared to reverse mode: " << 100.0 * data.sweepSavingsAvg << "%"
+                  << std::endl;
+      }
+
+      if (preaccs.splitThreshold > 0.0) {
+        std::cout << "Work items split into tasks per run: " << data.splitItemsAvg << " of " << preaccs.nPreaccs
+                  << std::endl;
+      }
+
+      if (preaccs.globalTape.scheme != GlobalTape::NONE) {
+        std::cout << "Global tape of the last run: " << preaccs.globalTape.getNumberOfRecords() << " records, "
+                  << preaccs.globalTape.getSize() << " bytes, checksum " << preaccs.globalTape.getChecksum()
+                  << std::endl;
+      }
+
+      if (counters) {
+        PerfCounters::print(std::cout, data.hardwareCounters, nRuns);
+      }
+
+      if (strategy == EvaluationStrategy::ADAPTIVE) {
+        Adaptive::print(std::cout, data.pathCounts, nRuns);
+      }
+
+      return 0;
+    }
+};
+
 /// Benchmarking executable.
 /// Mandatory arguments: nPreaccs preaccSizeMin preaccSizeMax nEvalMin nEvalMax iMin iMax nWarmups nRuns strategy
-/// Optional arguments: randomSeed
+/// Optional arguments: randomSeed, options of the form --name=value
 /// Strategies are numbered starting with zero in the order as in EvaluationStrategy::Strategy.
 int main(int argc, char** argv) {
-  using EvaluationStrategy::Strategy;
-  using Identifier = int;
-  using Gradient = double;
-
   if (argc < 11) {
-    std::cout << "Usage: ./benchmark nPreaccs preaccSizeMin preaccSizeMax nEvalMin nEvalMax iMin iMax nWarmups nRuns"
-              << " strategy [randomSeed] " << std::endl << std::endl;
-    std::cout << "nPreaccs: number of preaccumulations" << std::endl;
-    std::cout << "preaccSizeMin: minimum size of preaccumulations" << std::endl;
-    std::cout << "preaccSizeMax: maximum size of preaccumulations" << std::endl;
-    std::cout << "nEvalMin: minimum number of evaluations per preaccumulation" << std::endl;
-    std::cout << "nEvalMax: maximum number of evaluations per preaccumulation" << std::endl;
-    std::cout << "iMin: minimum identifier" << std::endl;
-    std::cout << "iMax: maximum identifier" << std::endl;
-    std::cout << "nWarmups: number of discarded warmup runs" << std::endl;
-    std::cout << "nRuns: number of benchmark runs" << std::endl;
-    std::cout << "strategy:" << std::endl;
-    std::cout << "  0: temporary vector" << std::endl;
-    std::cout << "  1: persistent vector" << std::endl;
-    std::cout << "  2: persistent vector with offset" << std::endl;
-    std::cout << "  3: temporary map, std::map" << std::endl;
-    std::cout << "  4: temporary map, std::unordered_map" << std::endl;
-    std::cout << "  5: editing with std::map, temporary vector" << std::endl;
-    std::cout << "  6: editing with std::unordered_map, temporary vector" << std::endl;
-    std::cout << "randomSeed: specify a random seed, defaults to 42, generated workload is deterministic w.r.t. this seed"
-              << std::endl << std::endl;
-    std::cout << "Output: [strategy] [number of threads] [nWarmups] [nRuns] [average time] [minimum time] "
-                 "[maximum time] [memory hwm] [checksum]" << std::endl << std::endl;
-    std::cout << "Set number of threads by setting OMP_NUM_THREADS." << std::endl;
+    printUsage();
     return 1;
   }
 
-  size_t nPreaccs = std::stol(argv[1]);
-  size_t preaccSizeMin = std::stol(argv[2]);
-  size_t preaccSizeMax = std::stol(argv[3]);
-  size_t nEvalMin = std::stol(argv[4]);
-  size_t nEvalMax = std::stol(argv[5]);
-  size_t iMin = std::stol(argv[6]);
-  size_t iMax = std::stol(argv[7]);
+  WorkloadParameters workload;
+  workload.nPreaccs = std::stol(argv[1]);
+  workload.preaccSizeMin = std::stol(argv[2]);
+  workload.preaccSizeMax = std::stol(argv[3]);
+  workload.nEvalMin = std::stol(argv[4]);
+  workload.nEvalMax = std::stol(argv[5]);
+  workload.iMin = std::stol(argv[6]);
+  workload.iMax = std::stol(argv[7]);
   size_t nWarmups = std::stol(argv[8]);
   size_t nRuns = std::stol(argv[9]);
   size_t strategy = std::stoi(argv[10]);
 
-  size_t randomSeed = 42;
-  if (argc == 12) {
-    randomSeed = std::stol(argv[11]);
-  }
-
-  Preaccumulations<Identifier, Gradient> preaccs(nPreaccs, preaccSizeMin, preaccSizeMax, nEvalMin, nEvalMax, iMin, iMax,
-                                                 randomSeed);
-
-  Benchmark<Identifier, Gradient> benchmark(nWarmups, nRuns);
-
-  std::cout << std::setw(5) << strategy;
-  switch (strategy) {
-    case 0:
-      std::cout << benchmark.run<Strategy::TEMPORARY_VECTOR>(preaccs) << std::endl;
-      break;
-    case 1:
-      std::cout << benchmark.run<Strategy::PERSISTENT_VECTOR>(preaccs) << std::endl;
-      break;
-    case 2:
-      std::cout << benchmark.run<Strategy::PERSISTENT_VECTOR_OFFSET>(preaccs) << std::endl;
-      break;
-    case 3:
-      std::cout << benchmark.run<Strategy::TEMPORARY_MAP>(preaccs) << std::endl;
-      break;
-    case 4:
-      std::cout << benchmark.run<Strategy::TEMPORARY_UNORDERED_MAP>(preaccs) << std::endl;
-      break;
-    case 5:
-      std::cout << benchmark.run<Strategy::TEMPORARY_MAP_EDITING>(preaccs) << std::endl;
-      break;
-    case 6:
-      std::cout << benchmark.run<Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(preaccs) << std::endl;
-      break;
-  }
-
-  return 0;
+  PreaccumulationOptions preaccOptions;
+  preaccOptions.randomSeed = 42;
+  std::map<std::string, std::string> options;
+  for (int i = 11; i < argc; ++i) {
+    std::string argument = argv[i];
+    if (argument.compare(0, 2, "--") == 0) {
+      size_t separator = argument.find('=');
+      if (separator == std::string::npos) {
+        options[argument.substr(2)] = "";
+      } else {
+        options[argument.substr(2, separator - 2)] = argument.substr(separator + 1);
+      }
+    } else {
+      preaccOptions.randomSeed = std::stol(argument);
+    }
+  }
+
+  preaccOptions.vectorWidth = std::stol(takeOption(options, "vector-width", "1"));
+  preaccOptions.pregenerate = takeFlag(options, "pregenerate");
+  preaccOptions.keepRemapped = takeFlag(options, "keep-remapped");
+  std::string scheduleName = takeOption(options, "schedule", "static");
+  preaccOptions.chunkSize = std::stol(takeOption(options, "chunk-size", "0"));
+  std::string allocatorName = takeOption(options, "allocator", "default");
+  bool placement = takeFlag(options, "placement");
+  bool counters = takeFlag(options, "counters");
+  bool memory = takeFlag(options, "memory");
+  Memory::getSamplingInterval() = std::stol(takeOption(options, "memory-samples", "0"));
+  std::string adaptiveCosts = takeOption(options, "adaptive-costs", "");
+  std::string recordPath = takeOption(options, "record", "");
+  preaccOptions.replayPath = takeOption(options, "replay", "");
+  preaccOptions.stream = takeFlag(options, "stream");
+  std::string identifierModel = takeOption(options, "identifiers", "uniform");
+  preaccOptions.statementTapes = options.count("statements") != 0;
+  std::string statementShape = takeOption(options, "statements", "");
+  std::string globalTapeScheme = takeOption(options, "global-tape", "none");
+  std::string modeName = takeOption(options, "mode", "reverse");
+  preaccOptions.inputs = parseList(takeOption(options, "inputs", ""), ',');
+  preaccOptions.splitThreshold = std::stod(takeOption(options, "split", "0"));
+  std::vector<size_t> prefetchDistances = parseList(takeOption(options, "prefetch", "0"), ',');
+  preaccOptions.identifierType = takeOption(options, "identifier", getTypeName<int32_t>());
+  preaccOptions.gradientType = takeOption(options, "gradient", getTypeName<double>());
+
+  bool sweep = options.count("strategies") != 0 || options.count("threads") != 0 ||
+               options.count("workloads") != 0 || options.count("format") != 0 || prefetchDistances.size() > 1;
+  std::vector<size_t> strategies = parseList(takeOption(options, "strategies", std::to_string(strategy)), ',');
+  std::vector<size_t> threads = parseList(takeOption(options, "threads", std::to_string(omp_get_max_threads())), ',');
+  std::string workloadList = takeOption(options, "workloads", "");
+  std::string format = takeOption(options, "format", "csv");
+  std::string outputName = takeOption(options, "output", "");
+
+  if (!options.empty()) {
+    std::cout << "Unknown option --" << options.begin()->first << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!isSupportedType(preaccOptions.identifierType, preaccOptions.gradientType)) {
+    std::cout << "Unsupported identifier type " << preaccOptions.identifierType << " or gradient type "
+              << preaccOptions.gradientType << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!Preaccumulations<int32_t, double>::isSupportedVectorWidth(preaccOptions.vectorWidth)) {
+    std::cout << "Unsupported vector width " << preaccOptions.vectorWidth << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!preaccOptions.replayPath.empty() && (preaccOptions.pregenerate || !recordPath.empty())) {
+    std::cout << "--replay cannot be combined with --pregenerate or --record." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!parseIdentifierModel(identifierModel, preaccOptions.identifierModel)) {
+    std::cout << "Unknown identifier model " << identifierModel << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (preaccOptions.statementTapes && !parseStatementShape(statementShape, preaccOptions.statementShape)) {
+    std::cout << "Invalid statement shape " << statementShape << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (preaccOptions.statementTapes &&
+      (preaccOptions.pregenerate || !recordPath.empty() || !preaccOptions.replayPath.empty())) {
+    std::cout << "--statements cannot be combined with --pregenerate, --record or --replay." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!parseSchedule(scheduleName, preaccOptions.schedule)) {
+    std::cout << "Unknown schedule " << scheduleName << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!parseMode(modeName, preaccOptions.mode)) {
+    std::cout << "Unknown mode " << modeName << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!preaccOptions.inputs.empty() &&
+      (preaccOptions.inputs.size() != 2 || preaccOptions.inputs[0] == 0 ||
+       preaccOptions.inputs[0] > preaccOptions.inputs[1])) {
+    std::cout << "Expected two values 0 < min <= max for --inputs." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (prefetchDistances.empty()) {
+    std::cout << "Expected at least one distance for --prefetch." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!parseGlobalTapeScheme(globalTapeScheme, preaccOptions.globalTapeScheme)) {
+    std::cout << "Unknown global tape scheme " << globalTapeScheme << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (!parseAllocator(allocatorName, Allocation::getKind())) {
+    std::cout << "Unknown allocator " << allocatorName << "." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+  Allocation::getPlacementEnabled() = placement;
+  PerfCounters::getEnabled() = counters;
+
+  if (!adaptiveCosts.empty() && !parseCostModel(adaptiveCosts, Adaptive::getCostModel())) {
+    std::cout << "Expected six values for --adaptive-costs." << std::endl << std::endl;
+    printUsage();
+    return 1;
+  }
+
+  if (sweep) {
+    std::vector<WorkloadParameters> workloads;
+    if (workloadList.empty()) {
+      workloads.push_back(workload);
+    } else if (!parseWorkloads(workloadList, workloads)) {
+      std::cout << "Expected seven values per workload in --workloads." << std::endl << std::endl;
+      printUsage();
+      return 1;
+    }
+
+    if (format != "csv" && format != "json") {
+      std::cout << "Unknown format " << format << "." << std::endl << std::endl;
+      printUsage();
+      return 1;
+    }
+    bool json = format == "json";
+
+    std::ofstream outputFile;
+    if (!outputName.empty()) {
+      outputFile.open(outputName);
+      if (!outputFile) {
+        std::cout << "Cannot open " << outputName << "." << std::endl;
+        return 1;
+      }
+    }
+    std::ostream& output = outputName.empty() ? std::cout : outputFile;
+
+    if (json) {
+      output << "[" << std::endl;
+    } else {
+      writeCsvHeader(output);
+    }
+
+    bool first = true;
+    bool failed = false;
+    for (auto const& configurationWorkload : workloads) {
+      for (size_t nThreads : threads) {
+        for (size_t configurationStrategy : strategies) {
+          for (size_t distance : prefetchDistances) {
+            getPrefetchDistance() = distance;
+            std::string record = runInChild(configurationStrategy, nThreads, configurationWorkload, preaccOptions,
+                                            nWarmups, nRuns, json);
+            if (record.empty()) {
+              std::cerr << "Strategy " << configurationStrategy << " with " << nThreads << " threads and prefetch"
+                        << " distance " << distance << " failed." << std::endl;
+              failed = true;
+              continue;
+            }
+            if (json && !first) {
+              output << "," << std::endl;
+            }
+            output << record;
+            output.flush();
+            first = false;
+          }
+        }
+      }
+    }
+
+    if (json) {
+      output << std::endl << "]" << std::endl;
+    }
+
+    return failed ? 1 : 0;
+  }
+
+  getPrefetchDistance() = prefetchDistances[0];
+  return dispatchTypes(preaccOptions, SingleRun{strategy, workload, preaccOptions, nWarmups, nRuns, recordPath,
+                                                placement, counters, memory});
 }
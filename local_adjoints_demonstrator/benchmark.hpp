@@ -1,11 +1,20 @@
 #pragma once
 
+#include <algorithm>
 #include <chrono>
-#include <fstream>
+#include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <omp.h>
 #include <ostream>
+#include <vector>
 
+#include "adaptive.hpp"
+#include "allocation.hpp"
+#include "allocation_counter.hpp"
+#include "instrumentation.hpp"
+#include "memory.hpp"
+#include "perf_counters.hpp"
 #include "preaccumulations.hpp"
 
 template<typename Gradient>
@@ -16,9 +25,27 @@ struct PerformanceData {
     size_t nRuns;
 
     double runtimeAvg, runtimeMin, runtimeMax;
-    double memoryHwm;
+    double runtimeMedian, runtimeStddev;
+    double runtimeP05, runtimeP95;       /// 5th and 95th percentile
+    double runtimeCiLow, runtimeCiHigh;  /// 95% confidence interval of the average
+    std::vector<double> runtimes;        /// runtimes of all benchmark runs
+    double memoryHwm;        /// high water mark in MB, of the benchmark runs if it could be reset, else of the process
+    bool memoryHwmReset;     /// whether the high water mark was reset before each benchmark run
+    double memoryBase;       /// resident set size in MB before the benchmark runs, e.g., the workload
+    double loadImbalanceAvg;
+    double forwardItemsAvg;  /// work items evaluated in forward mode per run
+    double sweepSavingsAvg;  /// fraction of swept tape entries saved by the mode compared to reverse mode
+    double splitItemsAvg;    /// work items split into tasks per run
 
     Gradient result;
+
+    std::vector<Instrumentation::ThreadTimes> threadTimes;  /// per-thread times over all runs, if instrumented
+    Allocation::Placement placement;  /// pages of persistent adjoint vectors per node over all runs, if enabled
+    Adaptive::PathCounts pathCounts;  /// tapes per path of the adaptive strategy over all runs
+    std::vector<AllocationCounter::Counts> allocations;  /// per-thread allocations over all runs, if counted
+    std::vector<PerfCounters::Counts> hardwareCounters;  /// per-thread hardware counters over all runs, if enabled
+    std::vector<Memory::AdjointPeaks> adjointPeaks;  /// per-thread peak bytes of local adjoints over all runs
+    std::vector<Memory::Sample> rssSamples;          /// resident set sizes sampled during the runs, if enabled
 };
 
 template<typename Gradient>
@@ -30,10 +57,124 @@ std::ostream& operator<<(std::ostream& out, PerformanceData<Gradient> const& dat
       << std::setw(16) << data.runtimeMin
       << std::setw(16) << data.runtimeMax
       << std::setw(16) << data.memoryHwm
-      << std::setw(16) << data.result;
+      << std::setw(16) << data.result
+      << std::setw(16) << data.loadImbalanceAvg;
   return out;
 }
 
+namespace Statistics {
+  /// Percentile of sorted values with linear interpolation, fraction in [0, 1].
+  inline double getPercentile(std::vector<double> const& sorted, double fraction) {
+    if (sorted.empty()) {
+      return 0.0;
+    }
+    double position = fraction * (sorted.size() - 1);
+    size_t lower = static_cast<size_t>(position);
+    size_t upper = std::min(lower + 1, sorted.size() - 1);
+    return sorted[lower] + (position - lower) * (sorted[upper] - sorted[lower]);
+  }
+
+  /// 97.5% quantile of Student's t-distribution, for two-sided 95% confidence intervals.
+  inline double getStudentT(size_t degreesOfFreedom) {
+    static double const quantiles[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                       2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                       2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degreesOfFreedom == 0) {
+      return 0.0;
+    }
+    if (degreesOfFreedom <= sizeof(quantiles) / sizeof(quantiles[0])) {
+      return quantiles[degreesOfFreedom - 1];
+    }
+    return 1.960;
+  }
+}
+
+/// Name of an identifier or gradient type the benchmark can be instantiated with, as used on the command line.
+template<typename Type>
+char const* getTypeName();
+
+template<>
+inline char const* getTypeName<int32_t>() {
+  return "int32";
+}
+
+template<>
+inline char const* getTypeName<int64_t>() {
+  return "int64";
+}
+
+template<>
+inline char const* getTypeName<uint32_t>() {
+  return "uint32";
+}
+
+template<>
+inline char const* getTypeName<uint64_t>() {
+  return "uint64";
+}
+
+template<>
+inline char const* getTypeName<float>() {
+  return "float";
+}
+
+template<>
+inline char const* getTypeName<double>() {
+  return "double";
+}
+
+/// Write the column names of writeCsv.
+inline void writeCsvHeader(std::ostream& out) {
+  out << "strategy,threads,nPreaccs,preaccSizeMin,preaccSizeMax,nEvalMin,nEvalMax,iMin,iMax,nWarmups,nRuns,"
+      << "average,minimum,maximum,median,stddev,p05,p95,ciLow,ciHigh,memoryHwm,checksum,loadImbalance,globalTape,"
+      << "mode,sweepSavings,identifier,gradient,memoryBase,adjointMemory,rssPeak,splitThreshold,splitItems,prefetch"
+      << std::endl;
+}
+
+/// Write the results of a benchmark as one line of comma-separated values.
+template<typename Identifier, typename Gradient>
+void writeCsv(std::ostream& out, size_t strategy, Preaccumulations<Identifier, Gradient> const& preaccs,
+              PerformanceData<Gradient> const& data) {
+  out << std::setprecision(10) << strategy << ',' << data.nThreads << ',' << preaccs.nPreaccs << ','
+      << preaccs.preaccSizeMin << ',' << preaccs.preaccSizeMax << ',' << preaccs.nEvalMin << ',' << preaccs.nEvalMax
+      << ',' << preaccs.iMin << ',' << preaccs.iMax << ',' << data.nWarmups << ',' << data.nRuns << ','
+      << data.runtimeAvg << ',' << data.runtimeMin << ',' << data.runtimeMax << ',' << data.runtimeMedian << ','
+      << data.runtimeStddev << ',' << data.runtimeP05 << ',' << data.runtimeP95 << ',' << data.runtimeCiLow << ','
+      << data.runtimeCiHigh << ',' << data.memoryHwm << ',' << data.result << ',' << data.loadImbalanceAvg << ','
+      << GlobalTape::getSchemeName(preaccs.globalTape.scheme) << ',' << EvaluationStrategy::getModeName(preaccs.mode)
+      << ',' << data.sweepSavingsAvg << ',' << getTypeName<Identifier>() << ',' << getTypeName<Gradient>() << ','
+      << data.memoryBase << ',' << Memory::getAdjointTotal(data.adjointPeaks) << ','
+      << Memory::getPeak(data.rssSamples) << ',' << preaccs.splitThreshold << ',' << data.splitItemsAvg << ','
+      << getPrefetchDistance() << std::endl;
+}
+
+/// Write the results of a benchmark as a JSON object, including the runtimes of all runs.
+template<typename Identifier, typename Gradient>
+void writeJson(std::ostream& out, size_t strategy, Preaccumulations<Identifier, Gradient> const& preaccs,
+               PerformanceData<Gradient> const& data) {
+  out << std::setprecision(10) << "  {\"strategy\": " << strategy << ", \"threads\": " << data.nThreads
+      << ", \"nPreaccs\": " << preaccs.nPreaccs << ", \"preaccSizeMin\": " << preaccs.preaccSizeMin
+      << ", \"preaccSizeMax\": " << preaccs.preaccSizeMax << ", \"nEvalMin\": " << preaccs.nEvalMin
+      << ", \"nEvalMax\": " << preaccs.nEvalMax << ", \"iMin\": " << preaccs.iMin << ", \"iMax\": " << preaccs.iMax
+      << ", \"nWarmups\": " << data.nWarmups << ", \"nRuns\": " << data.nRuns << ", \"average\": " << data.runtimeAvg
+      << ", \"minimum\": " << data.runtimeMin << ", \"maximum\": " << data.runtimeMax << ", \"median\": "
+      << data.runtimeMedian << ", \"stddev\": " << data.runtimeStddev << ", \"p05\": " << data.runtimeP05
+      << ", \"p95\": " << data.runtimeP95 << ", \"ciLow\": " << data.runtimeCiLow << ", \"ciHigh\": "
+      << data.runtimeCiHigh << ", \"memoryHwm\": " << data.memoryHwm << ", \"checksum\": " << data.result
+      << ", \"loadImbalance\": " << data.loadImbalanceAvg << ", \"globalTape\": \""
+      << GlobalTape::getSchemeName(preaccs.globalTape.scheme) << "\", \"mode\": \""
+      << EvaluationStrategy::getModeName(preaccs.mode) << "\", \"sweepSavings\": " << data.sweepSavingsAvg
+      << ", \"identifier\": \"" << getTypeName<Identifier>() << "\", \"gradient\": \"" << getTypeName<Gradient>()
+      << "\", \"memoryBase\": " << data.memoryBase << ", \"adjointMemory\": "
+      << Memory::getAdjointTotal(data.adjointPeaks) << ", \"rssPeak\": " << Memory::getPeak(data.rssSamples)
+      << ", \"splitThreshold\": " << preaccs.splitThreshold << ", \"splitItems\": " << data.splitItemsAvg
+      << ", \"prefetch\": " << getPrefetchDistance() << ", \"runtimes\": [";
+  for (size_t i = 0; i < data.runtimes.size(); ++i) {
+    out << (i == 0 ? "" : ", ") << data.runtimes[i];
+  }
+  out << "]}";
+}
+
 template<typename Identifier, typename Gradient>
 struct Benchmark {
   public:
@@ -42,19 +183,24 @@ struct Benchmark {
 
     Benchmark(size_t nWarmups, size_t nRuns) : nWarmups(nWarmups), nRuns(nRuns) {}
 
-    /// Get memory high water mark in MB.
-    double getMemoryHWM() {
-      std::ifstream process("/proc/self/status");
-
-      std::string buffer;
-      do {
-        process >> buffer;
-      } while (buffer != "VmHWM:");
+    /// Compute median, standard deviation, percentiles and confidence interval of the recorded runtimes.
+    void computeStatistics(PerformanceData<Gradient>& data) {
+      std::vector<double> sorted = data.runtimes;
+      std::sort(sorted.begin(), sorted.end());
+      data.runtimeMedian = Statistics::getPercentile(sorted, 0.5);
+      data.runtimeP05 = Statistics::getPercentile(sorted, 0.05);
+      data.runtimeP95 = Statistics::getPercentile(sorted, 0.95);
 
-      size_t result = 0;
-      process >> result;
+      double sumOfSquares = 0.0;
+      for (double runtime : sorted) {
+        sumOfSquares += (runtime - data.runtimeAvg) * (runtime - data.runtimeAvg);
+      }
+      size_t n = sorted.size();
+      data.runtimeStddev = n > 1 ? std::sqrt(sumOfSquares / (n - 1)) : 0.0;
 
-      return static_cast<double>(result) / 1024.0;
+      double halfWidth = n > 1 ? Statistics::getStudentT(n - 1) * data.runtimeStddev / std::sqrt(n) : 0.0;
+      data.runtimeCiLow = data.runtimeAvg - halfWidth;
+      data.runtimeCiHigh = data.runtimeAvg + halfWidth;
     }
 
     /// Benchmarks simultaneous preaccumulations.
@@ -67,13 +213,35 @@ struct Benchmark {
       data.runtimeAvg = 0.0;
       data.runtimeMin = std::numeric_limits<double>::max();
       data.runtimeMax = std::numeric_limits<double>::min();
+      data.loadImbalanceAvg = 0.0;
+      data.forwardItemsAvg = 0.0;
+      data.sweepSavingsAvg = 0.0;
+      data.splitItemsAvg = 0.0;
+      data.memoryHwm = 0.0;
       data.result = 0.0;
 
       for (size_t i = 0; i < nWarmups; ++i) {
         data.result += preaccs.template run<strategy>(1.0);
       }
 
+      data.memoryHwmReset = Memory::resetHighWaterMark();
+      data.memoryBase = Memory::getResidentSetSize();
+      Memory::resetAdjointPeaks();
+      Memory::Sampler sampler;
+      sampler.start(Memory::getSamplingInterval());
+
+      Instrumentation::reset();
+      Allocation::resetPlacement();
+      Adaptive::reset();
+      if (AllocationCounter::isEnabled()) {
+        AllocationCounter::reset();
+      }
+
+      PerfCounters::start();
       for (size_t i = 0; i < nRuns; ++i) {
+        if (data.memoryHwmReset) {
+          Memory::resetHighWaterMark();
+        }
         auto start = std::chrono::high_resolution_clock::now();
         data.result += preaccs.template run<strategy>(1.0);
         auto end = std::chrono::high_resolution_clock::now();
@@ -82,9 +250,27 @@ struct Benchmark {
         data.runtimeAvg = (data.runtimeAvg * i + elapsed) / (i + 1);
         data.runtimeMin = std::min(data.runtimeMin, elapsed);
         data.runtimeMax = std::max(data.runtimeMax, elapsed);
+        data.loadImbalanceAvg = (data.loadImbalanceAvg * i + preaccs.loadImbalance) / (i + 1);
+        data.forwardItemsAvg = (data.forwardItemsAvg * i + preaccs.nForwardItems) / (i + 1);
+        data.sweepSavingsAvg = (data.sweepSavingsAvg * i + preaccs.sweepSavings) / (i + 1);
+        data.splitItemsAvg = (data.splitItemsAvg * i + preaccs.nSplitItems) / (i + 1);
+        data.runtimes.push_back(elapsed);
+        data.memoryHwm = std::max(data.memoryHwm, Memory::getHighWaterMark());
       }
+      data.hardwareCounters = PerfCounters::stop();
+      data.rssSamples = sampler.stop();
 
-      data.memoryHwm = getMemoryHWM();
+      computeStatistics(data);
+      if (!data.memoryHwmReset) {
+        data.memoryHwm = Memory::getHighWaterMark();
+      }
+      data.adjointPeaks = Memory::collectAdjointPeaks();
+      data.threadTimes = Instrumentation::getCollectedTimes();
+      data.placement = Allocation::getRecordedPlacement();
+      data.pathCounts = Adaptive::getCollectedCounts();
+      if (AllocationCounter::isEnabled()) {
+        data.allocations = AllocationCounter::collect();
+      }
 
       return data;
     }
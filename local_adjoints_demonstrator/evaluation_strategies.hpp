@@ -1,8 +1,14 @@
 #pragma once
 
-#include <list>
+#include <cstdint>
+#include <limits>
 
+#include "adaptive.hpp"
+#include "gradient_pack.hpp"
+#include "instrumentation.hpp"
 #include "local_adjoints.hpp"
+#include "span.hpp"
+#include "statement_tape.hpp"
 #include "tape.hpp"
 
 /// Defines and implements the different tape evaluation strategies for preaccumulation.
@@ -16,122 +22,570 @@ namespace EvaluationStrategy {
     TEMPORARY_MAP = 3,
     TEMPORARY_UNORDERED_MAP = 4,
     TEMPORARY_MAP_EDITING = 5,
-    TEMPORARY_UNORDERED_MAP_EDITING = 6
+    TEMPORARY_UNORDERED_MAP_EDITING = 6,
+    PERSISTENT_FLAT_MAP = 7,
+    PERSISTENT_EPOCH_VECTOR = 8,
+    TEMPORARY_MAP_EDITING_COMPACT = 9,
+    TEMPORARY_UNORDERED_MAP_EDITING_COMPACT = 10,
+    RADIX_SORT_EDITING = 11,
+    FLAT_MAP_EDITING = 12,
+    PERSISTENT_RESERVED_VECTOR = 13,
+    ADAPTIVE = 14,
+    TEMPORARY_MAP_ARENA = 15,
+    TEMPORARY_UNORDERED_MAP_ARENA = 16,
+    TEMPORARY_MAP_EDITING_ARENA = 17,
+    TEMPORARY_UNORDERED_MAP_EDITING_ARENA = 18,
+    PERSISTENT_PAGED_VECTOR = 19
   };
 
+  /// Whether the strategy edits tapes, i.e., remaps their identifiers in place, at least for some tapes.
+  constexpr bool isEditing(Strategy strategy) {
+    return strategy == TEMPORARY_MAP_EDITING || strategy == TEMPORARY_UNORDERED_MAP_EDITING ||
+           strategy == TEMPORARY_MAP_EDITING_COMPACT || strategy == TEMPORARY_UNORDERED_MAP_EDITING_COMPACT ||
+           strategy == RADIX_SORT_EDITING || strategy == FLAT_MAP_EDITING || strategy == ADAPTIVE ||
+           strategy == TEMPORARY_MAP_EDITING_ARENA || strategy == TEMPORARY_UNORDERED_MAP_EDITING_ARENA;
+  }
+
+  /// Direction of tape evaluations.
+  enum Mode {
+    REVERSE = 0,    /// adjoints from the outputs to the inputs, one sweep per output of a work item
+    FORWARD = 1,    /// tangents from the inputs to the outputs, one sweep per input of a work item
+    AUTOMATIC = 2,  /// per work item, the direction with fewer sweeps, not a direction of sweeps itself
+  };
+
+  inline char const* getModeName(Mode mode) {
+    static char const* const names[] = {"reverse", "forward", "automatic"};
+    return names[mode];
+  }
+
   namespace Implementation {
+    /// Prepare adjoint variables for the next tape evaluation. Nothing to do if the evaluation auto-zeroes.
+    template<bool autoZero>
+    struct PrepareSweep {
+      public:
+        template<typename Adjoints>
+        static void prepare(Adjoints&) {}
+    };
+
+    /// Without auto-zeroing, adjoint variables are invalidated in bulk.
+    template<>
+    struct PrepareSweep<false> {
+      public:
+        template<typename Adjoints>
+        static void prepare(Adjoints& adjoints) {
+          adjoints.nextEpoch();
+        }
+    };
+
+    /// Evaluate a tape in the given direction. Local adjoint containers hold tangents in forward mode.
+    template<Mode mode>
+    struct Propagate {
+      public:
+        static_assert(mode == REVERSE, "Sweeps are either forward or reverse.");
+
+        template<bool autoZero, typename TapeType, typename Adjoints, typename Adjoint>
+        static Adjoint evaluate(TapeType& tape, Adjoints& adjoints, Adjoint const& seed) {
+          return tape.template evaluate<autoZero>(adjoints, seed);
+        }
+    };
+
+    template<>
+    struct Propagate<FORWARD> {
+      public:
+        template<bool autoZero, typename TapeType, typename Tangents, typename Tangent>
+        static Tangent evaluate(TapeType& tape, Tangents& tangents, Tangent const& seed) {
+          return tape.template evaluateForward<autoZero>(tangents, seed);
+        }
+    };
+  }
+
+  /// Scalar mode, one tape evaluation per seed.
+  template<typename Gradient, Mode mode = REVERSE>
+  struct ScalarSweeps {
+    public:
+      using Adjoint = Gradient;
+      using ForwardSweeps = ScalarSweeps<Gradient, FORWARD>;
+      static constexpr size_t seedsPerSweep = 1;
+
+      template<bool autoZero = true, typename TapeType, typename Adjoints>
+      static Gradient evaluate(TapeType& tape, Adjoints& adjoints, Span<Gradient const> seeds) {
+        Gradient result = 0.0;
+        for (auto const& seed : seeds) {
+          Implementation::PrepareSweep<autoZero>::prepare(adjoints);
+          result += Implementation::Propagate<mode>::template evaluate<autoZero>(tape, adjoints, seed);
+        }
+        return result;
+      }
+  };
+
+  /// Vector mode, one tape evaluation per pack of up to width seeds. Unused lanes of the last pack are seeded with zero.
+  template<typename Gradient, size_t width, Mode mode = REVERSE>
+  struct VectorSweeps {
+    public:
+      using Adjoint = GradientPack<Gradient, width>;
+      using ForwardSweeps = VectorSweeps<Gradient, width, FORWARD>;
+      static constexpr size_t seedsPerSweep = width;
+
+      template<bool autoZero = true, typename TapeType, typename Adjoints>
+      static Gradient evaluate(TapeType& tape, Adjoints& adjoints, Span<Gradient const> seeds) {
+        Gradient result = 0.0;
+        auto seed = seeds.begin();
+        while (seed != seeds.end()) {
+          Adjoint pack(0.0);
+          for (size_t lane = 0; lane < width && seed != seeds.end(); ++lane, ++seed) {
+            pack.lanes[lane] = *seed;
+          }
+          Implementation::PrepareSweep<autoZero>::prepare(adjoints);
+          result += Implementation::Propagate<mode>::template evaluate<autoZero>(tape, adjoints, pack).sum();
+        }
+        return result;
+      }
+  };
+
+  namespace Implementation {
+    /// Evaluate a remapped tape with a temporary vector after compacting its identifiers to the given type, in
+    /// thread-local scratch memory.
+    template<typename CompactIdentifier, typename Sweeps, typename TapeType, typename Identifier, typename Gradient>
+    Gradient evaluateCompact(TapeType const& tape, Identifier maxIdentifier, Span<Gradient const> seeds) {
+      decltype(tape.template compact<CompactIdentifier>()) compactTape;
+      {
+        Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+        compactTape = tape.template compact<CompactIdentifier>();
+      }
+      LocalAdjoints::TemporaryVector<CompactIdentifier, typename Sweeps::Adjoint> adjoints;
+      {
+        Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+        adjoints.resize(maxIdentifier + 1);
+      }
+      Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+      return Sweeps::evaluate(compactTape, adjoints, seeds);
+    }
+
+    /// Evaluate a remapped tape with a temporary vector, using the narrowest identifier type that fits.
+    template<typename Sweeps, typename TapeType, typename Gradient>
+    Gradient evaluateCompact(TapeType const& tape, Span<Gradient const> seeds) {
+      auto maxIdentifier = tape.getMaxIdentifier();
+      if (maxIdentifier <= std::numeric_limits<uint8_t>::max()) {
+        return evaluateCompact<uint8_t, Sweeps>(tape, maxIdentifier, seeds);
+      } else if (maxIdentifier <= std::numeric_limits<uint16_t>::max()) {
+        return evaluateCompact<uint16_t, Sweeps>(tape, maxIdentifier, seeds);
+      } else {
+        return evaluateCompact<uint32_t, Sweeps>(tape, maxIdentifier, seeds);
+      }
+    }
+
     /// Implement evaluations of a given tape with the specified evaluation strategy, specialized for each strategy.
+    /// Local adjoint variables are of the adjoint type of the sweeps, i.e., scalars or packs of gradients.
     template<typename Identifier, typename Gradient, Strategy evaluationStrategy>
     struct Evaluate {
       public:
-        // static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {}
+        // template<typename Sweeps, typename TapeType>
+        // static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {}
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_VECTOR> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          LocalAdjoints::TemporaryVector<Identifier, Gradient> adjoints;
-          adjoints.resize(tape.getMaxIdentifier() + 1);
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
           }
-          return result;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_VECTOR> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          LocalAdjoints::PersistentVector<Identifier, Gradient> adjoints;
-          adjoints.resize(tape.getMaxIdentifier() + 1);
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
           }
-          return result;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          LocalAdjoints::PersistentVectorOffset<Identifier, Gradient> adjoints(tape.getMinIdentifier());
-          adjoints.resize(tape.getMaxIdentifier() - tape.getMinIdentifier() + 1);
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentVectorOffset<Identifier, typename Sweeps::Adjoint> adjoints(tape.getMinIdentifier());
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier() - tape.getMinIdentifier()) + 1);
           }
-          return result;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_MAP> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          LocalAdjoints::TemporaryMapStdMap<Identifier, Gradient> adjoints;
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
-          }
-          return result;
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::TemporaryMapStdMap<Identifier, typename Sweeps::Adjoint> adjoints;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          LocalAdjoints::TemporaryMapStdUnorderedMap<Identifier, Gradient> adjoints;
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
-          }
-          return result;
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::TemporaryMapStdUnorderedMap<Identifier, typename Sweeps::Adjoint> adjoints;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          tape.template remapIdentifiers<std::map<Identifier, Identifier>>();
-          LocalAdjoints::TemporaryVector<Identifier, Gradient> adjoints;
-          adjoints.resize(tape.getMaxIdentifier() + 1);
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.template remapIdentifiers<std::map<Identifier, Identifier>>();
           }
-          return result;
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
         }
     };
 
     template<typename Identifier, typename Gradient>
     struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING> {
       public:
-        static Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-          tape.template remapIdentifiers<std::unordered_map<Identifier, Identifier>>();
-          LocalAdjoints::TemporaryVector<Identifier, Gradient> adjoints;
-          adjoints.resize(tape.getMaxIdentifier() + 1);
-          Gradient result = 0.0;
-          for (auto const& seed : seeds) {
-            result += tape.evaluate(adjoints, seed);
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.template remapIdentifiers<std::unordered_map<Identifier, Identifier>>();
+          }
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentFlatMap<Identifier, typename Sweeps::Adjoint> adjoints;
+          Gradient result;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+            result = Sweeps::evaluate(tape, adjoints, seeds);
           }
+          Instrumentation::ScopedTimer timer(Instrumentation::CLEAR);
+          adjoints.reset();
+          return result;
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentEpochVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::template evaluate<false>(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.template remapIdentifiers<std::map<Identifier, Identifier>>();
+          }
+          return evaluateCompact<Sweeps>(tape, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.template remapIdentifiers<std::unordered_map<Identifier, Identifier>>();
+          }
+          return evaluateCompact<Sweeps>(tape, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::RADIX_SORT_EDITING> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.remapIdentifiersRadixSort();
+          }
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::FLAT_MAP_EDITING> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            tape.remapIdentifiersFlatMap();
+          }
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentReservedVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    /// Chooses one of the kernels of strategies 2, 7 and 11 per tape, based on tape statistics and the cost model.
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::ADAPTIVE> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          Adaptive::Path path = choosePath<Sweeps>(tape, seeds.size());
+          return evaluatePath<Sweeps>(path, tape, seeds);
+        }
+
+        /// Choose the path for a tape evaluated with the given number of seeds and count it.
+        template<typename Sweeps, typename TapeType>
+        static Adaptive::Path choosePath(TapeType const& tape, size_t nSeeds) {
+          Adaptive::Path path;
+          if (tape.remapped) {
+            path = Adaptive::EDITING;  // kept remapped tapes are evaluated without further remapping
+          } else {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            size_t nSweeps = (nSeeds + Sweeps::seedsPerSweep - 1) / Sweeps::seedsPerSweep;
+            path = Adaptive::getCostModel().choose(Adaptive::computeStatistics<Identifier>(tape, nSweeps));
+          }
+          ++Adaptive::getLocalCounts().counts[path];
+          return path;
+        }
+
+        /// Evaluate the tape with the kernel of the given path.
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluatePath(Adaptive::Path path, TapeType& tape, Span<Gradient const> seeds) {
+          switch (path) {
+            case Adaptive::VECTOR_OFFSET:
+              return Evaluate<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>::template evaluate<Sweeps>(
+                  tape, seeds);
+            case Adaptive::MAP:
+              return Evaluate<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>::template evaluate<Sweeps>(tape,
+                                                                                                              seeds);
+            default:
+              return Evaluate<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>::template evaluate<Sweeps>(tape,
+                                                                                                             seeds);
+          }
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          Allocation::ArenaScope arenaScope;
+          LocalAdjoints::TemporaryMapStdMapArena<Identifier, typename Sweeps::Adjoint> adjoints;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          Allocation::ArenaScope arenaScope;
+          LocalAdjoints::TemporaryMapStdUnorderedMapArena<Identifier, typename Sweeps::Adjoint> adjoints;
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            Allocation::ArenaScope arenaScope;
+            tape.template remapIdentifiers<
+                std::map<Identifier, Identifier, std::less<Identifier>,
+                         Allocation::ArenaAllocator<std::pair<Identifier const, Identifier>>>>();
+          }
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::REMAPPING);
+            Allocation::ArenaScope arenaScope;
+            tape.template remapIdentifiers<
+                std::unordered_map<Identifier, Identifier, std::hash<Identifier>, std::equal_to<Identifier>,
+                                   Allocation::ArenaAllocator<std::pair<Identifier const, Identifier>>>>();
+          }
+          LocalAdjoints::TemporaryVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+          return Sweeps::evaluate(tape, adjoints, seeds);
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct Evaluate<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR> {
+      public:
+        template<typename Sweeps, typename TapeType>
+        static Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+          LocalAdjoints::PersistentPagedVector<Identifier, typename Sweeps::Adjoint> adjoints;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SETUP);
+            adjoints.resize(static_cast<size_t>(tape.getMaxIdentifier()) + 1);
+          }
+          Gradient result;
+          {
+            Instrumentation::ScopedTimer timer(Instrumentation::SWEEPS);
+            result = Sweeps::evaluate(tape, adjoints, seeds);
+          }
+          Instrumentation::ScopedTimer timer(Instrumentation::CLEAR);
+          adjoints.reset();
           return result;
         }
     };
   }
 
   /// Evaluate a given tape, possibly multiple times, with the specified evaluation strategy and the given seeds.
-  template<typename Identifier, typename Gradient, Strategy evaluationStrategy>
-  Gradient evaluate(Tape<Identifier, Gradient>& tape, std::list<Gradient> const& seeds) {
-    return Implementation::Evaluate<Identifier, Gradient, evaluationStrategy>::evaluate(tape, seeds);
+  /// Seeds are propagated one at a time (scalar mode) or in packs (vector mode), depending on the sweeps.
+  /// The tape is a Tape, a TapeView or a StatementTape, editing strategies modify its identifiers.
+  template<typename Identifier, typename Gradient, Strategy evaluationStrategy,
+           typename Sweeps = ScalarSweeps<Gradient>, typename TapeType>
+  Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) {
+    return Implementation::Evaluate<Identifier, Gradient, evaluationStrategy>::template evaluate<Sweeps>(tape, seeds);
   }
 
+  /** @brief Evaluation of a tape in groups of its seeds, which may run concurrently after the first group.
+   *
+   *  Editing strategies remap the tape in the first group, the other groups read the remapped tape. Per-tape choices,
+   *  i.e., the path of the adaptive strategy, are made once for all seeds when the evaluation is constructed.
+   */
+  template<typename Identifier, typename Gradient, Strategy evaluationStrategy, typename Sweeps>
+  struct GroupEvaluation {
+    public:
+      template<typename TapeType>
+      GroupEvaluation(TapeType const& tape, size_t nSeeds) {
+        (void)tape;
+        (void)nSeeds;
+      }
+
+      /// Whether the first group has to be evaluated before the others, as it remaps the tape.
+      bool isEditing() const {
+        return EvaluationStrategy::isEditing(evaluationStrategy);
+      }
+
+      template<typename TapeType>
+      Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) const {
+        return EvaluationStrategy::evaluate<Identifier, Gradient, evaluationStrategy, Sweeps>(tape, seeds);
+      }
+  };
+
+  template<typename Identifier, typename Gradient, typename Sweeps>
+  struct GroupEvaluation<Identifier, Gradient, ADAPTIVE, Sweeps> {
+    public:
+      using Kernel = Implementation::Evaluate<Identifier, Gradient, ADAPTIVE>;
+
+      Adaptive::Path path;  /// chosen once per tape
+
+      template<typename TapeType>
+      GroupEvaluation(TapeType const& tape, size_t nSeeds)
+          : path(Kernel::template choosePath<Sweeps>(tape, nSeeds)) {}
+
+      bool isEditing() const {
+        return path == Adaptive::EDITING;
+      }
+
+      template<typename TapeType>
+      Gradient evaluate(TapeType& tape, Span<Gradient const> seeds) const {
+        return Kernel::template evaluatePath<Sweeps>(path, tape, seeds);
+      }
+  };
+
   namespace Implementation {
     /// Implement cleanup of adjoints specific to the evaluation strategy, specialized for the strategies as needed.
     template<typename Identifier, typename Gradient, Strategy evaluationStrategy>
@@ -157,11 +611,125 @@ namespace EvaluationStrategy {
           adjoints.clear();
         }
     };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>  {
+      public:
+        static void clearAdjoints() {
+          LocalAdjoints::PersistentFlatMap<Identifier, Gradient> adjoints;
+          adjoints.clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>  {
+      public:
+        static void clearAdjoints() {
+          LocalAdjoints::PersistentEpochVector<Identifier, Gradient> adjoints;
+          adjoints.clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>  {
+      public:
+        static void clearAdjoints() {
+          CompactingScratch<uint8_t>::clear();
+          CompactingScratch<uint16_t>::clear();
+          CompactingScratch<uint32_t>::clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>  {
+      public:
+        static void clearAdjoints() {
+          ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>::clearAdjoints();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>  {
+      public:
+        static void clearAdjoints() {
+          RemappingScratch<Identifier>::clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>  {
+      public:
+        static void clearAdjoints() {
+          RemappingScratch<Identifier>::clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>  {
+      public:
+        static void clearAdjoints() {
+          LocalAdjoints::PersistentReservedVector<Identifier, Gradient> adjoints;
+          adjoints.clear();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::ADAPTIVE>  {
+      public:
+        static void clearAdjoints() {
+          ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>::clearAdjoints();
+          ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>::clearAdjoints();
+          ClearAdjoints<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>::clearAdjoints();
+          Adaptive::flush();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>  {
+      public:
+        static void clearAdjoints() {
+          Allocation::getLocalArena().release();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>  {
+      public:
+        static void clearAdjoints() {
+          Allocation::getLocalArena().release();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>  {
+      public:
+        static void clearAdjoints() {
+          Allocation::getLocalArena().release();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>  {
+      public:
+        static void clearAdjoints() {
+          Allocation::getLocalArena().release();
+        }
+    };
+
+    template<typename Identifier, typename Gradient>
+    struct ClearAdjoints<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>  {
+      public:
+        static void clearAdjoints() {
+          LocalAdjoints::PersistentPagedVector<Identifier, Gradient> adjoints;
+          adjoints.clear();
+        }
+    };
   }
 
-  /// Cleanup of adjoints specific to the evaluation strategy.
-  template<typename Identifier, typename Gradient, Strategy evaluationStrategy>
+  /// Cleanup of adjoints specific to the evaluation strategy, for the adjoint type of the given sweeps.
+  template<typename Identifier, typename Gradient, Strategy evaluationStrategy,
+           typename Sweeps = ScalarSweeps<Gradient>>
   void clearAdjoints() {
-    Implementation::ClearAdjoints<Identifier, Gradient, evaluationStrategy>::clearAdjoints();
+    Implementation::ClearAdjoints<Identifier, typename Sweeps::Adjoint, evaluationStrategy>::clearAdjoints();
   }
 }
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+/** @brief Open-addressing hash map with linear probing.
+ *
+ *  Keys and values are stored next to each other in a single contiguous array of slots. The largest value of the key
+ *  type, emptyKey(), is reserved to mark empty slots and cannot be inserted. Resetting only touches occupied slots and keeps the capacity, so that a map
+ *  that is reused for similarly sized workloads does not allocate in steady state.
+ *
+ *  References returned by operator[] are invalidated by subsequent insertions.
+ */
+template<typename Key, typename Value>
+struct FlatMap {
+  public:
+    struct Entry {
+      Key key;
+      Value value;
+    };
+
+    std::vector<Entry> entries;    /// slots, the capacity is zero or a power of two
+    std::vector<size_t> occupied;  /// indices of occupied slots
+    size_t shift;                  /// 64 - log2(capacity), for multiplicative hashing
+
+    FlatMap() : entries(), occupied(), shift(64) {}
+
+    /// Key of empty slots, reserved.
+    static Key emptyKey() {
+      return std::numeric_limits<Key>::max();
+    }
+
+    /// Access the value for the given key, inserts a value-initialized entry if the key is not present. Throws
+    /// std::invalid_argument for the reserved emptyKey().
+    Value& operator[](Key key) {
+      if (key == emptyKey()) {
+        throw std::invalid_argument("The largest value of the key type is reserved for empty slots of a FlatMap.");
+      }
+      if (2 * (occupied.size() + 1) > entries.size()) {  // keep the load factor at or below 0.5
+        grow();
+      }
+
+      size_t index = slot(key);
+      while (true) {
+        Entry& entry = entries[index];
+        if (entry.key == key) {
+          return entry.value;
+        }
+        if (entry.key == emptyKey()) {
+          entry.key = key;
+          entry.value = Value();
+          occupied.push_back(index);
+          return entry.value;
+        }
+        index = (index + 1) & (entries.size() - 1);
+      }
+    }
+
+    /// Prefetch the slot of the given key for writing, the slot of an inserted key may differ after growing.
+    void prefetch(Key key) const {
+      if (!entries.empty()) {
+        __builtin_prefetch(entries.data() + slot(key), 1);
+      }
+    }
+
+    size_t size() const {
+      return occupied.size();
+    }
+
+    /// Bytes of the slots and the indices of occupied slots.
+    size_t getBytes() const {
+      return entries.capacity() * sizeof(Entry) + occupied.capacity() * sizeof(size_t);
+    }
+
+    /// Remove all entries but keep the capacity.
+    void reset() {
+      for (auto const& index : occupied) {
+        entries[index].key = emptyKey();
+      }
+      occupied.clear();
+    }
+
+  private:
+    size_t slot(Key key) const {
+      return static_cast<size_t>((static_cast<uint64_t>(key) * UINT64_C(0x9E3779B97F4A7C15)) >> shift);
+    }
+
+    void grow() {
+      std::vector<Entry> previousEntries(std::max<size_t>(16, 2 * entries.size()), Entry{emptyKey(), Value()});
+      previousEntries.swap(entries);
+
+      shift = 64;
+      for (size_t capacity = entries.size(); capacity > 1; capacity /= 2) {
+        --shift;
+      }
+
+      std::vector<size_t> previousOccupied;
+      previousOccupied.swap(occupied);
+      occupied.reserve(entries.size() / 2);
+
+      for (auto const& previousIndex : previousOccupied) {
+        Entry const& previousEntry = previousEntries[previousIndex];
+        size_t index = slot(previousEntry.key);
+        while (entries[index].key != emptyKey()) {
+          index = (index + 1) & (entries.size() - 1);
+        }
+        entries[index] = previousEntry;
+        occupied.push_back(index);
+      }
+    }
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+/// Models of the identifiers of generated tapes, from uniform to the locality patterns of real tapes.
+namespace Generators {
+
+  enum Model {
+    UNIFORM = 0,    /// identifiers drawn uniformly from [iMin, iMax]
+    CLUSTERED = 1,  /// identifiers close to a cursor that advances by one per entry and occasionally jumps
+    ZIPF = 2,       /// identifiers drawn by Zipf-distributed rank, hot identifiers are reused across all work items
+    SHARED = 3,     /// neighbouring work items draw a fraction of their identifiers from a common set
+  };
+
+  /// Model and parameters, only those of the selected model are used.
+  struct Parameters {
+    public:
+      Model model;
+      size_t windowSize;       /// CLUSTERED: identifiers are drawn from the windowSize identifiers up to the cursor
+      double jumpProbability;  /// CLUSTERED: probability per entry that the cursor jumps to a random position
+      double zipfExponent;     /// ZIPF: rank k is drawn with probability proportional to 1 / k^zipfExponent
+      size_t groupSize;        /// SHARED: number of neighbouring work items that share an identifier set
+      size_t sharedSetSize;    /// SHARED: number of identifiers in the shared set of a group
+      double sharedFraction;   /// SHARED: probability per entry to draw from the shared set instead of uniformly
+
+      Parameters()
+          : model(UNIFORM), windowSize(256), jumpProbability(0.01), zipfExponent(1.0), groupSize(8),
+            sharedSetSize(1024), sharedFraction(0.5) {}
+  };
+
+  /// Mix the bits of the given value, splitmix64 finalizer.
+  inline uint64_t mix(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+  }
+
+  inline uint64_t getGreatestCommonDivisor(uint64_t a, uint64_t b) {
+    while (b != 0) {
+      uint64_t remainder = a % b;
+      a = b;
+      b = remainder;
+    }
+    return a;
+  }
+
+  /** @brief Zipf distribution over the ranks 1 to n by rejection-inversion.
+   *
+   *  W. Hörmann, G. Derflinger: Rejection-inversion to generate variates from monotone discrete distributions.
+   *  Constant setup and expected sampling time, independent of n.
+   */
+  struct ZipfDistribution {
+    public:
+      double exponent;
+      double n;
+      double hIntegralX1;
+      double hIntegralN;
+      double s;
+
+      ZipfDistribution(uint64_t n, double exponent) : exponent(exponent), n(static_cast<double>(n)) {
+        hIntegralX1 = hIntegral(1.5) - 1.0;
+        hIntegralN = hIntegral(this->n + 0.5);
+        s = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+      }
+
+      template<typename Generator>
+      uint64_t operator()(Generator& generator) const {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        while (true) {
+          double u = hIntegralN + uniform(generator) * (hIntegralX1 - hIntegralN);
+          double x = hIntegralInverse(u);
+          double k = std::min(std::max(std::floor(x + 0.5), 1.0), n);
+          if (k - x <= s || u >= hIntegral(k + 0.5) - h(k)) {
+            return static_cast<uint64_t>(k);
+          }
+        }
+      }
+
+    private:
+      double h(double x) const {
+        return std::exp(-exponent * std::log(x));
+      }
+
+      double hIntegral(double x) const {
+        double logX = std::log(x);
+        return helper2((1.0 - exponent) * logX) * logX;
+      }
+
+      double hIntegralInverse(double x) const {
+        double t = std::max(x * (1.0 - exponent), -1.0);
+        return std::exp(helper1(t) * x);
+      }
+
+      /// log(1 + x) / x, accurate for small x
+      static double helper1(double x) {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+      }
+
+      /// (exp(x) - 1) / x, accurate for small x
+      static double helper2(double x) {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+      }
+  };
+
+  /// Draw identifiers in [iMin, iMax] according to the model. The shared set of the SHARED model is derived from
+  /// groupSeed, which neighbouring work items have in common. Uses generator only, so that the result is deterministic
+  /// with respect to its state.
+  template<typename Identifier, typename Generator>
+  void drawIdentifiers(Identifier* identifiers, size_t size, Identifier iMin, Identifier iMax,
+                       Parameters const& parameters, uint64_t groupSeed, Generator& generator) {
+    uint64_t range = static_cast<uint64_t>(iMax) - static_cast<uint64_t>(iMin) + 1;
+
+    switch (parameters.model) {
+      case CLUSTERED: {
+        uint64_t window = std::max<uint64_t>(std::min<uint64_t>(parameters.windowSize, range), 1);
+        std::uniform_int_distribution<uint64_t> positionDistribution(0, range - 1);
+        std::uniform_int_distribution<uint64_t> offsetDistribution(0, window - 1);
+        std::bernoulli_distribution jumpDistribution(parameters.jumpProbability);
+
+        uint64_t cursor = positionDistribution(generator);
+        for (size_t i = 0; i < size; ++i) {
+          if (jumpDistribution(generator)) {
+            cursor = positionDistribution(generator);
+          } else {
+            cursor = (cursor + 1) % range;
+          }
+          identifiers[i] = iMin + static_cast<Identifier>((cursor + range - offsetDistribution(generator)) % range);
+        }
+        break;
+      }
+      case ZIPF: {
+        // scatter ranks over the identifier range by a stride coprime to the range
+        uint64_t stride = 2654435761ull % range;
+        while (range > 1 && getGreatestCommonDivisor(stride, range) != 1) {
+          ++stride;
+        }
+
+        ZipfDistribution distribution(range, parameters.zipfExponent);
+        for (size_t i = 0; i < size; ++i) {
+          uint64_t rank = distribution(generator);
+          identifiers[i] = iMin + static_cast<Identifier>((rank - 1) * stride % range);
+        }
+        break;
+      }
+      case SHARED: {
+        std::uniform_int_distribution<Identifier> distribution(iMin, iMax);
+        std::uniform_int_distribution<size_t> sharedDistribution(0, std::max<size_t>(parameters.sharedSetSize, 1) - 1);
+        std::bernoulli_distribution sharedChoice(parameters.sharedFraction);
+
+        for (size_t i = 0; i < size; ++i) {
+          if (sharedChoice(generator)) {
+            uint64_t element = sharedDistribution(generator);
+            identifiers[i] = iMin + static_cast<Identifier>(mix(groupSeed * 0x100000001B3ull + element) % range);
+          } else {
+            identifiers[i] = distribution(generator);
+          }
+        }
+        break;
+      }
+      default: {
+        std::uniform_int_distribution<Identifier> distribution(iMin, iMax);
+        for (size_t i = 0; i < size; ++i) {
+          identifiers[i] = distribution(generator);
+        }
+        break;
+      }
+    }
+  }
+}
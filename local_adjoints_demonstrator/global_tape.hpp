@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "span.hpp"
+
+/** @brief Shared global tape that stores the preaccumulated Jacobians of all work items.
+ *
+ *  In an AD tool, each thread stores the result of a preaccumulation, i.e., one statement per output whose arguments
+ *  are the inputs, in the global tape. Each result is stored as a record of a header with the numbers of inputs and
+ *  outputs, the input identifiers, the output identifiers, and the Jacobian in row-major order. Records are padded to
+ *  multiples of recordAlignment bytes and never span chunks. Padding records fill the remainders of chunks.
+ */
+namespace GlobalTape {
+
+  /// Concurrency schemes of pushes into the global tape.
+  enum Scheme {
+    NONE = 0,      /// results are not stored
+    LOCK = 1,      /// records are appended to a chunked buffer under a global lock
+    ATOMIC = 2,    /// records are placed in a chunked buffer by an atomic fetch-and-add on the write position
+    SEGMENTS = 3,  /// records are appended to per-thread segments, which are concatenated after all work items
+  };
+
+  inline char const* getSchemeName(Scheme scheme) {
+    static char const* const names[] = {"none", "lock", "atomic", "segments"};
+    return names[scheme];
+  }
+
+  size_t const recordAlignment = 8;
+
+  struct RecordHeader {
+    public:
+      uint32_t nInputs;   /// paddingMarker for padding records
+      uint32_t nOutputs;  /// size in bytes for padding records
+  };
+
+  uint32_t const paddingMarker = 0xFFFFFFFF;
+
+  inline size_t roundUp(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+  }
+
+  /// Byte offset of the Jacobian within a record.
+  template<typename Identifier, typename Gradient>
+  size_t getJacobianOffset(size_t nInputs, size_t nOutputs) {
+    return roundUp(sizeof(RecordHeader) + (nInputs + nOutputs) * sizeof(Identifier), alignof(Gradient));
+  }
+
+  template<typename Identifier, typename Gradient>
+  size_t getRecordSize(size_t nInputs, size_t nOutputs) {
+    return roundUp(getJacobianOffset<Identifier, Gradient>(nInputs, nOutputs) + nInputs * nOutputs * sizeof(Gradient),
+                   recordAlignment);
+  }
+
+  /// View of a stored record.
+  template<typename Identifier, typename Gradient>
+  struct Record {
+    public:
+      Span<Identifier const> inputs;
+      Span<Identifier const> outputs;
+      Span<Gradient const> jacobian;  /// row-major, one row per output
+  };
+
+  /** @brief Global tape with the push scheme selected at runtime.
+   *
+   *  clear is called before and merge after the pushes of a run, push by all threads in between. Records are read
+   *  with visit once the run is done. Copies share the configuration, but not the recorded data.
+   */
+  template<typename Identifier, typename Gradient>
+  struct Buffer {
+    public:
+      static size_t const defaultChunkSize = 1 << 20;
+      static size_t const maxChunks = 1 << 16;
+
+      /// Per-thread segment of the SEGMENTS scheme, padded against false sharing of the write positions.
+      struct Segment {
+        public:
+          std::vector<char> data;  /// grows to the largest segment, kept across clears
+          size_t size;             /// bytes in use
+          size_t offset;           /// byte offset in the concatenated segments
+          char padding[64];
+      };
+
+      Scheme scheme;
+      size_t chunkSize;  /// bytes per chunk of the LOCK and ATOMIC schemes
+
+      std::unique_ptr<std::atomic<char*>[]> chunks;  /// allocated on demand, kept across clears
+      std::atomic<uint64_t> position;                /// write position over all chunks
+      std::vector<Segment> segments;                 /// indexed by OpenMP thread number
+      std::vector<char> merged;                      /// concatenated segments, kept across clears
+      size_t mergedSize;                             /// bytes of merged in use
+
+      Buffer() : scheme(NONE), chunkSize(defaultChunkSize), chunks(), position(0), segments(), merged(),
+                 mergedSize(0) {}
+
+      Buffer(Buffer const& other) : Buffer() {
+        scheme = other.scheme;
+        chunkSize = other.chunkSize;
+      }
+
+      Buffer& operator=(Buffer const& other) {
+        if (this != &other) {
+          release();
+          scheme = other.scheme;
+          chunkSize = other.chunkSize;
+        }
+        return *this;
+      }
+
+      ~Buffer() {
+        release();
+      }
+
+      /// Discard all records before a run with at most nThreads threads, keeping the memory. Throws
+      /// std::invalid_argument if records of the given maximum size do not fit into a chunk.
+      void clear(size_t nThreads, size_t maxRecordSize) {
+        if (maxRecordSize > chunkSize) {
+          throw std::invalid_argument("Records of " + std::to_string(maxRecordSize) + " bytes exceed the chunk size.");
+        }
+        if (!chunks) {
+          chunks.reset(new std::atomic<char*>[maxChunks]);
+          for (size_t chunk = 0; chunk < maxChunks; ++chunk) {
+            chunks[chunk].store(nullptr);
+          }
+        }
+        position.store(0);
+        segments.resize(std::max(segments.size(), nThreads));
+        for (auto& segment : segments) {
+          segment.size = 0;
+        }
+        mergedSize = 0;
+      }
+
+      /// Store a record. Thread-safe for all schemes. Throws std::length_error if the record does not fit into the
+      /// maxChunks chunks of the LOCK and ATOMIC schemes.
+      void push(Span<Identifier const> inputs, Span<Identifier const> outputs, Span<Gradient const> jacobian) {
+        size_t bytes = getRecordSize<Identifier, Gradient>(inputs.size(), outputs.size());
+
+        switch (scheme) {
+          case LOCK: {
+            bool full = false;
+            #pragma omp critical(GlobalTapeLock)
+            {
+              uint64_t begin = position.load(std::memory_order_relaxed);
+              size_t remainder = chunkSize - begin % chunkSize;
+              full = (bytes > remainder ? begin + remainder : begin) / chunkSize >= maxChunks;
+              if (!full) {
+                if (bytes > remainder) {
+                  writePadding(getChunk(begin / chunkSize) + begin % chunkSize, remainder);
+                  begin += remainder;
+                }
+                writeRecord(getChunk(begin / chunkSize) + begin % chunkSize, inputs, outputs, jacobian);
+                position.store(begin + bytes, std::memory_order_relaxed);
+              }
+            }
+            if (full) {
+              throwFull();
+            }
+            break;
+          }
+          case ATOMIC:
+            writeRecord(reserve(bytes), inputs, outputs, jacobian);
+            break;
+          case SEGMENTS: {
+            Segment& segment = segments[omp_get_thread_num()];
+            if (segment.data.size() < segment.size + bytes) {
+              segment.data.resize(std::max(2 * segment.data.size(), segment.size + bytes));
+            }
+            writeRecord(segment.data.data() + segment.size, inputs, outputs, jacobian);
+            segment.size += bytes;
+            break;
+          }
+          default:
+            break;
+        }
+      }
+
+      /// Concatenate the segments of the SEGMENTS scheme in thread order, each thread copies its own segment. To be
+      /// called by all threads of a parallel region once all threads are done pushing.
+      void merge() {
+        if (scheme != SEGMENTS) {
+          return;
+        }
+
+        #pragma omp single
+        {
+          size_t offset = 0;
+          for (auto& segment : segments) {
+            segment.offset = offset;
+            offset += segment.size;
+          }
+          if (merged.size() < offset) {
+            merged.resize(offset);
+          }
+          mergedSize = offset;
+        }
+
+        Segment const& segment = segments[omp_get_thread_num()];
+        if (segment.size != 0) {
+          std::memcpy(merged.data() + segment.offset, segment.data.data(), segment.size);
+        }
+      }
+
+      /// Call visitor with each record, in the order of the global tape.
+      template<typename Visitor>
+      void visit(Visitor&& visitor) const {
+        if (scheme == SEGMENTS) {
+          visitBlock(merged.data(), mergedSize, visitor);
+        } else if (chunks) {
+          uint64_t end = position.load();
+          for (size_t chunk = 0; chunk < maxChunks && chunk * chunkSize < end; ++chunk) {
+            visitBlock(chunks[chunk].load(), std::min<uint64_t>(chunkSize, end - chunk * chunkSize), visitor);
+          }
+        }
+      }
+
+      /// Bytes in use, including padding.
+      size_t getSize() const {
+        return scheme == SEGMENTS ? mergedSize : std::min<size_t>(position.load(), maxChunks * chunkSize);
+      }
+
+      size_t getNumberOfRecords() const {
+        size_t nRecords = 0;
+        visit([&](Record<Identifier, Gradient> const&) { ++nRecords; });
+        return nRecords;
+      }
+
+      /// Sum of all stored Jacobian entries.
+      Gradient getChecksum() const {
+        Gradient checksum = 0.0;
+        visit([&](Record<Identifier, Gradient> const& record) {
+          for (auto const& entry : record.jacobian) {
+            checksum += entry;
+          }
+        });
+        return checksum;
+      }
+
+    private:
+      void release() {
+        if (chunks) {
+          for (size_t chunk = 0; chunk < maxChunks; ++chunk) {
+            ::operator delete(chunks[chunk].load());
+          }
+          chunks.reset();
+        }
+        position.store(0);
+        segments = std::vector<Segment>();
+        merged = std::vector<char>();
+        mergedSize = 0;
+      }
+
+      void throwFull() const {
+        throw std::length_error("The global tape exceeds " + std::to_string(maxChunks) + " chunks of " +
+                                std::to_string(chunkSize) + " bytes.");
+      }
+
+      /// Chunk with the given index, allocated by the first thread that needs it. Throws std::length_error if the
+      /// index is not below maxChunks.
+      char* getChunk(size_t chunk) {
+        if (chunk >= maxChunks) {
+          throwFull();
+        }
+        char* data = chunks[chunk].load(std::memory_order_acquire);
+        if (data == nullptr) {
+          char* allocated = static_cast<char*>(::operator new(chunkSize));
+          if (chunks[chunk].compare_exchange_strong(data, allocated, std::memory_order_acq_rel)) {
+            data = allocated;
+          } else {
+            ::operator delete(allocated);
+          }
+        }
+        return data;
+      }
+
+      /// Reserve the given number of bytes within a chunk. Reservations that span two chunks are filled with padding
+      /// records, as other threads may have reserved the subsequent bytes already, and reserved again.
+      char* reserve(size_t bytes) {
+        while (true) {
+          uint64_t begin = position.fetch_add(bytes, std::memory_order_relaxed);
+          uint64_t chunkEnd = (begin / chunkSize + 1) * chunkSize;
+          if (begin + bytes <= chunkEnd) {
+            return getChunk(begin / chunkSize) + begin % chunkSize;
+          }
+          writePadding(getChunk(begin / chunkSize) + begin % chunkSize, chunkEnd - begin);
+          writePadding(getChunk(chunkEnd / chunkSize), begin + bytes - chunkEnd);
+        }
+      }
+
+      static void writePadding(char* target, size_t bytes) {
+        RecordHeader header = {paddingMarker, static_cast<uint32_t>(bytes)};
+        std::memcpy(target, &header, sizeof(header));
+      }
+
+      static void writeRecord(char* target, Span<Identifier const> inputs, Span<Identifier const> outputs,
+                              Span<Gradient const> jacobian) {
+        RecordHeader header = {static_cast<uint32_t>(inputs.size()), static_cast<uint32_t>(outputs.size())};
+        std::memcpy(target, &header, sizeof(header));
+        Identifier* identifiers = reinterpret_cast<Identifier*>(target + sizeof(header));
+        std::copy(inputs.begin(), inputs.end(), identifiers);
+        std::copy(outputs.begin(), outputs.end(), identifiers + inputs.size());
+        std::copy(jacobian.begin(), jacobian.end(),
+                  reinterpret_cast<Gradient*>(target + getJacobianOffset<Identifier, Gradient>(inputs.size(),
+                                                                                               outputs.size())));
+      }
+
+      template<typename Visitor>
+      static void visitBlock(char const* data, size_t bytes, Visitor& visitor) {
+        size_t offset = 0;
+        while (offset < bytes) {
+          RecordHeader header;
+          std::memcpy(&header, data + offset, sizeof(header));
+          if (header.nInputs == paddingMarker) {
+            offset += header.nOutputs;
+            continue;
+          }
+
+          Identifier const* identifiers = reinterpret_cast<Identifier const*>(data + offset + sizeof(header));
+          Record<Identifier, Gradient> record;
+          record.inputs = Span<Identifier const>(identifiers, header.nInputs);
+          record.outputs = Span<Identifier const>(identifiers + header.nInputs, header.nOutputs);
+          record.jacobian = Span<Gradient const>(
+              reinterpret_cast<Gradient const*>(data + offset +
+                                                getJacobianOffset<Identifier, Gradient>(header.nInputs,
+                                                                                        header.nOutputs)),
+              header.nInputs * header.nOutputs);
+          visitor(record);
+          offset += getRecordSize<Identifier, Gradient>(header.nInputs, header.nOutputs);
+        }
+      }
+  };
+}
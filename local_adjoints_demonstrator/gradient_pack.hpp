@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+
+/** @brief Fixed-width pack of gradients for vector mode evaluations.
+ *
+ *  Each lane carries the adjoint value with respect to a different seed. Arithmetic is implemented lane-wise in loops
+ *  of compile-time length, which compilers turn into SIMD instructions.
+ */
+template<typename Gradient, size_t width>
+struct GradientPack {
+  public:
+    Gradient lanes[width];
+
+    GradientPack() : GradientPack(Gradient()) {}
+
+    /// Broadcast a scalar to all lanes, in particular to allow for zeroing by assignment of 0.0.
+    GradientPack(Gradient const& value) {
+      for (size_t lane = 0; lane < width; ++lane) {
+        lanes[lane] = value;
+      }
+    }
+
+    GradientPack operator*(Gradient const& factor) const {
+      GradientPack result;
+      for (size_t lane = 0; lane < width; ++lane) {
+        result.lanes[lane] = lanes[lane] * factor;
+      }
+      return result;
+    }
+
+    GradientPack& operator+=(GradientPack const& other) {
+      for (size_t lane = 0; lane < width; ++lane) {
+        lanes[lane] += other.lanes[lane];
+      }
+      return *this;
+    }
+
+    /// Sum over all lanes.
+    Gradient sum() const {
+      Gradient result = Gradient();
+      for (size_t lane = 0; lane < width; ++lane) {
+        result += lanes[lane];
+      }
+      return result;
+    }
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <omp.h>
+#include <ostream>
+#include <vector>
+
+/// Per-phase and per-thread timing of simultaneous preaccumulations.
+/// Compiled in only if LOCAL_ADJOINTS_INSTRUMENTATION is defined, otherwise all timers are empty and nothing is recorded.
+namespace Instrumentation {
+
+  /// Phases of the work on work items.
+  enum Phase {
+    GENERATION = 0,  /// tape generation, or copy of a pregenerated tape
+    EVALUATION = 1,  /// evaluation with the strategy, including the following three phases and the release of adjoints
+    REMAPPING = 2,   /// identifier remapping of editing strategies
+    SETUP = 3,       /// creation and resizing of local adjoint variables
+    SWEEPS = 4,      /// tape evaluations for all seeds
+    CLEAR = 5,       /// reset of reused adjoint variables after each tape and clearAdjoints after all work items
+    PUSH = 6,        /// storage of the results in the global tape, including the merge of per-thread segments
+    NUMBER_OF_PHASES = 7
+  };
+
+  inline char const* getPhaseName(Phase phase) {
+    static char const* const names[NUMBER_OF_PHASES] = {"generation", "evaluation", "remapping", "setup", "sweeps",
+                                                        "clear", "push"};
+    return names[phase];
+  }
+
+  /// Accumulated times of a thread in seconds.
+  struct ThreadTimes {
+    public:
+      double phases[NUMBER_OF_PHASES];
+      double busy;  /// time spent in the worksharing loop
+      double idle;  /// time spent waiting for other threads at the end of the worksharing loop
+
+      ThreadTimes() : phases(), busy(0.0), idle(0.0) {}
+
+      ThreadTimes& operator+=(ThreadTimes const& other) {
+        for (int phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+          phases[phase] += other.phases[phase];
+        }
+        busy += other.busy;
+        idle += other.idle;
+        return *this;
+      }
+  };
+
+  using Clock = std::chrono::steady_clock;
+
+  inline double getSeconds(Clock::time_point const& start, Clock::time_point const& end) {
+    return std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+  }
+
+  /// Times accumulated by the calling thread since the last flush.
+  inline ThreadTimes& getLocalTimes() {
+    static ThreadTimes* localTimes = nullptr;
+    #pragma omp threadprivate(localTimes)
+    if (localTimes == nullptr) {
+      localTimes = new ThreadTimes();
+    }
+    return *localTimes;
+  }
+
+  /// Flushed times of all threads, indexed by OpenMP thread number.
+  inline std::vector<ThreadTimes>& getCollectedTimes() {
+    static std::vector<ThreadTimes> collectedTimes;
+    return collectedTimes;
+  }
+
+  constexpr bool isEnabled() {
+    #ifdef LOCAL_ADJOINTS_INSTRUMENTATION
+      return true;
+    #else
+      return false;
+    #endif
+  }
+
+  /// Adds its lifetime to the given phase of the calling thread.
+  struct ScopedTimer {
+    public:
+      #ifdef LOCAL_ADJOINTS_INSTRUMENTATION
+        Phase phase;
+        Clock::time_point start;
+
+        explicit ScopedTimer(Phase phase) : phase(phase), start(Clock::now()) {}
+
+        ~ScopedTimer() {
+          getLocalTimes().phases[phase] += getSeconds(start, Clock::now());
+        }
+      #else
+        explicit ScopedTimer(Phase) {}
+      #endif
+  };
+
+  /// Measures the busy time of the calling thread in a worksharing loop and its idle time at the subsequent barrier.
+  /// Construct before the loop, call loopDone after the loop and barrierDone after the barrier, with the time of tasks
+  /// that the thread ran at the barrier, which counts as busy time.
+  struct LoopTimer {
+    public:
+      #ifdef LOCAL_ADJOINTS_INSTRUMENTATION
+        Clock::time_point start;
+
+        LoopTimer() : start(Clock::now()) {}
+
+        void loopDone() {
+          Clock::time_point end = Clock::now();
+          getLocalTimes().busy += getSeconds(start, end);
+          start = end;
+        }
+
+        void barrierDone(double taskTime = 0.0) {
+          getLocalTimes().busy += taskTime;
+          getLocalTimes().idle += getSeconds(start, Clock::now()) - taskTime;
+        }
+      #else
+        void loopDone() {}
+        void barrierDone(double = 0.0) {}
+      #endif
+  };
+
+  /// Add the times of the calling thread to the collected times. To be called by all threads of a parallel region.
+  inline void flush() {
+    #ifdef LOCAL_ADJOINTS_INSTRUMENTATION
+      #pragma omp critical(InstrumentationFlush)
+      {
+        auto& collectedTimes = getCollectedTimes();
+        size_t thread = omp_get_thread_num();
+        if (collectedTimes.size() <= thread) {
+          collectedTimes.resize(thread + 1);
+        }
+        collectedTimes[thread] += getLocalTimes();
+      }
+      getLocalTimes() = ThreadTimes();
+    #endif
+  }
+
+  /// Discard all collected times, e.g., after warmup runs.
+  inline void reset() {
+    getCollectedTimes().clear();
+  }
+
+  /// Report per-phase totals over all threads and per-thread times, averaged over the given number of runs.
+  inline void print(std::ostream& out, std::vector<ThreadTimes> const& times, size_t nRuns) {
+    ThreadTimes total;
+    for (auto const& threadTimes : times) {
+      total += threadTimes;
+    }
+
+    out << "Phase totals over all threads per run [s]:" << std::endl;
+    for (int phase = 0; phase < NUMBER_OF_PHASES; ++phase) {
+      out << std::setw(12) << getPhaseName(static_cast<Phase>(phase)) << std::setw(16) << total.phases[phase] / nRuns
+          << std::endl;
+    }
+
+    out << "Threads per run [s]:" << std::endl;
+    out << std::setw(12) << "thread" << std::setw(16) << "busy" << std::setw(16) << "idle" << std::endl;
+    for (size_t thread = 0; thread < times.size(); ++thread) {
+      out << std::setw(12) << thread << std::setw(16) << times[thread].busy / nRuns << std::setw(16)
+          << times[thread].idle / nRuns << std::endl;
+    }
+  }
+}
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
 #include <map>
+#include <new>
+#include <sys/mman.h>
 #include <unordered_map>
 #include <vector>
 
+#include "allocation.hpp"
+#include "flat_map.hpp"
+#include "memory.hpp"
+
 namespace LocalAdjoints {
 
   /// General interface for implementations of adjoint variables.
@@ -12,16 +20,36 @@ namespace LocalAdjoints {
     public:
       Gradient& operator[](Identifier identifier);
       Gradient const& operator[](Identifier identifier) const;
+      void prefetch(Identifier identifier) const;  /// hint that the adjoint variable is accessed soon
       void resize(size_t size);
       void clear();
   };
 
+  /// Estimated bytes of a std::map, per node the value and a header with the color and three pointers.
+  template<typename Key, typename Value, typename Compare, typename Allocator>
+  size_t getMapBytes(std::map<Key, Value, Compare, Allocator> const& map) {
+    return map.size() * (sizeof(std::pair<Key const, Value>) + 4 * sizeof(void*));
+  }
+
+  /// Estimated bytes of a std::unordered_map, per node the value and a pointer, and the bucket array.
+  template<typename Key, typename Value, typename Hash, typename Equal, typename Allocator>
+  size_t getMapBytes(std::unordered_map<Key, Value, Hash, Equal, Allocator> const& map) {
+    return map.size() * (sizeof(std::pair<Key const, Value>) + sizeof(void*)) + map.bucket_count() * sizeof(void*);
+  }
+
   /// Template for temporary mapped adjoint variables (underlying map to be specified).
   template<typename Identifier, typename Gradient, typename BasicMap>
   struct TemporaryMap : public AdjointsInterface<Identifier, Gradient> {
     public:
       BasicMap map;
 
+      TemporaryMap() : map() {}
+
+      /// The map only grows, so that it is largest when destructed.
+      ~TemporaryMap() {
+        Memory::recordAdjointBytes(Memory::TEMPORARY_MAP, getMapBytes(map));
+      }
+
       Gradient& operator[](Identifier identifier) {
         return map[identifier];
       }
@@ -30,8 +58,12 @@ namespace LocalAdjoints {
         return map[identifier];
       }
 
+      /// Nodes of std::map and std::unordered_map can only be located by the lookup itself.
+      void prefetch(Identifier) const {}
+
       void resize(size_t) {}
       void clear() {
+        Memory::recordAdjointBytes(Memory::TEMPORARY_MAP, getMapBytes(map));
         map.clear();
       }
   };
@@ -44,12 +76,32 @@ namespace LocalAdjoints {
   template<typename Identifier, typename Gradient>
   using TemporaryMapStdUnorderedMap = TemporaryMap<Identifier, Gradient, std::unordered_map<Identifier, Gradient>>;
 
+  /// Temporary mapped adjoint variables via std::map, nodes allocated from the thread-local arena.
+  template<typename Identifier, typename Gradient>
+  using TemporaryMapStdMapArena =
+      TemporaryMap<Identifier, Gradient,
+                   std::map<Identifier, Gradient, std::less<Identifier>,
+                            Allocation::ArenaAllocator<std::pair<Identifier const, Gradient>>>>;
+
+  /// Temporary mapped adjoint variables via std::unordered_map, nodes and buckets from the thread-local arena.
+  template<typename Identifier, typename Gradient>
+  using TemporaryMapStdUnorderedMapArena =
+      TemporaryMap<Identifier, Gradient,
+                   std::unordered_map<Identifier, Gradient, std::hash<Identifier>, std::equal_to<Identifier>,
+                                      Allocation::ArenaAllocator<std::pair<Identifier const, Gradient>>>>;
+
   /// Temporary vector of adjoint variables.
   template<typename Identifier, typename Gradient>
   struct TemporaryVector : public AdjointsInterface<Identifier, Gradient> {
     public:
       std::vector<Gradient> vector;
 
+      TemporaryVector() : vector() {}
+
+      ~TemporaryVector() {
+        Memory::recordAdjointBytes(Memory::TEMPORARY_VECTOR, vector.capacity() * sizeof(Gradient));
+      }
+
       Gradient& operator[](Identifier identifier) {
         return vector[identifier];
       }
@@ -58,20 +110,28 @@ namespace LocalAdjoints {
         return vector[identifier];
       }
 
+      void prefetch(Identifier identifier) const {
+        __builtin_prefetch(vector.data() + identifier, 1);
+      }
+
       void resize(size_t size) {
         vector.resize(size);
       }
 
       void clear() {
+        Memory::recordAdjointBytes(Memory::TEMPORARY_VECTOR, vector.capacity() * sizeof(Gradient));
         vector = std::vector<Gradient>();
       }
   };
 
   /// Base class for persistent vector-based adjoint variables (underlying thread-local memory reused across instances).
+  /// Memory is obtained from the allocator kind selected in Allocation.
   template<typename Identifier, typename Gradient>
   struct PersistentVectorBase : public AdjointsInterface<Identifier, Gradient> {
     public:
-      static std::vector<Gradient>* vector;
+      using Vector = std::vector<Gradient, Allocation::Allocator<Gradient>>;
+
+      static Vector* vector;
       #pragma omp threadprivate(vector)
 
       void resize(size_t size) {
@@ -81,12 +141,15 @@ namespace LocalAdjoints {
       }
 
       void clear() {
-        *vector = std::vector<Gradient>();
+        Allocation::recordPlacement(vector->data(), vector->size() * sizeof(Gradient));
+        Memory::recordAdjointBytes(Memory::PERSISTENT_VECTOR, vector->capacity() * sizeof(Gradient));
+        *vector = Vector();
       }
   };
 
   template<typename Identifier, typename Gradient>
-  std::vector<Gradient>* PersistentVectorBase<Identifier, Gradient>::vector = new std::vector<Gradient>();
+  typename PersistentVectorBase<Identifier, Gradient>::Vector* PersistentVectorBase<Identifier, Gradient>::vector =
+      new typename PersistentVectorBase<Identifier, Gradient>::Vector();
 
   /// Persistent vector of adjoint variables.
   template<typename Identifier, typename Gradient>
@@ -101,6 +164,10 @@ namespace LocalAdjoints {
       Gradient const& operator[](Identifier identifier) const {
         return Base::vector->operator [](identifier);
       }
+
+      void prefetch(Identifier identifier) const {
+        __builtin_prefetch(Base::vector->data() + identifier, 1);
+      }
   };
 
   /// Persistent vector of adjoint variables, addressing with offset.
@@ -120,5 +187,279 @@ namespace LocalAdjoints {
       Gradient const& operator[](Identifier identifier) const {
         return Base::vector->operator [](identifier - offset);
       }
+
+      void prefetch(Identifier identifier) const {
+        __builtin_prefetch(Base::vector->data() + (identifier - offset), 1);
+      }
   };
+
+  /// Persistent open-addressing map of adjoint variables (underlying thread-local map reused across instances).
+  /// Entries are dropped by reset after each tape, the capacity is kept.
+  template<typename Identifier, typename Gradient>
+  struct PersistentFlatMap : public AdjointsInterface<Identifier, Gradient> {
+    public:
+      static FlatMap<Identifier, Gradient>* map;
+      #pragma omp threadprivate(map)
+
+      Gradient& operator[](Identifier identifier) {
+        return map->operator [](identifier);
+      }
+
+      Gradient const& operator[](Identifier identifier) const {
+        return map->operator [](identifier);
+      }
+
+      void prefetch(Identifier identifier) const {
+        map->prefetch(identifier);
+      }
+
+      void resize(size_t) {}
+
+      void reset() {
+        map->reset();
+      }
+
+      void clear() {
+        Memory::recordAdjointBytes(Memory::PERSISTENT_FLAT_MAP, map->getBytes());
+        *map = FlatMap<Identifier, Gradient>();
+      }
+  };
+
+  template<typename Identifier, typename Gradient>
+  FlatMap<Identifier, Gradient>* PersistentFlatMap<Identifier, Gradient>::map = new FlatMap<Identifier, Gradient>();
+
+  /// Persistent vector of adjoint variables with epoch tags (underlying thread-local memory reused across instances).
+  /// Values tagged with an outdated epoch read as zero, so that starting a new epoch replaces zeroing of all values.
+  /// Memory is obtained from the allocator kind selected in Allocation.
+  template<typename Identifier, typename Gradient>
+  struct PersistentEpochVector : public AdjointsInterface<Identifier, Gradient> {
+    public:
+      struct Slot {
+        Gradient gradient;
+        uint32_t epoch;
+      };
+
+      using Vector = std::vector<Slot, Allocation::Allocator<Slot>>;
+
+      static Vector* vector;
+      static uint32_t currentEpoch;
+      #pragma omp threadprivate(vector, currentEpoch)
+
+      Gradient& operator[](Identifier identifier) {
+        Slot& slot = vector->operator [](identifier);
+        if (slot.epoch != currentEpoch) {
+          slot.gradient = Gradient();
+          slot.epoch = currentEpoch;
+        }
+        return slot.gradient;
+      }
+
+      Gradient const& operator[](Identifier identifier) const {
+        Slot& slot = vector->operator [](identifier);
+        if (slot.epoch != currentEpoch) {
+          slot.gradient = Gradient();
+          slot.epoch = currentEpoch;
+        }
+        return slot.gradient;
+      }
+
+      void prefetch(Identifier identifier) const {
+        __builtin_prefetch(vector->data() + identifier, 1);
+      }
+
+      /// New slots are tagged with epoch zero, which is never current.
+      void resize(size_t size) {
+        if (size > vector->size()) {
+          vector->resize(size);
+        }
+      }
+
+      /// Invalidate all values. Only on overflow of the epoch counter, the tags are reset explicitly.
+      void nextEpoch() {
+        if (++currentEpoch == 0) {
+          for (auto& slot : *vector) {
+            slot.epoch = 0;
+          }
+          currentEpoch = 1;
+        }
+      }
+
+      void clear() {
+        Allocation::recordPlacement(vector->data(), vector->size() * sizeof(Slot));
+        Memory::recordAdjointBytes(Memory::PERSISTENT_EPOCH_VECTOR, vector->capacity() * sizeof(Slot));
+        *vector = Vector();
+        currentEpoch = 1;
+      }
+  };
+
+  template<typename Identifier, typename Gradient>
+  typename PersistentEpochVector<Identifier, Gradient>::Vector* PersistentEpochVector<Identifier, Gradient>::vector =
+      new typename PersistentEpochVector<Identifier, Gradient>::Vector();
+
+  template<typename Identifier, typename Gradient>
+  uint32_t PersistentEpochVector<Identifier, Gradient>::currentEpoch = 1;
+
+  /** @brief Persistent vector of adjoint variables in reserved virtual memory (thread-local reservation reused across
+   *  instances).
+   *
+   *  Identifiers index an anonymous mapping directly. Untouched pages read as zero without occupying physical memory,
+   *  so that only pages of identifiers that occur in tapes count towards the resident memory. The reservation grows
+   *  to the next power of two by remapping and is usually established once per thread, clear releases the touched
+   *  pages but keeps the reservation.
+   */
+  template<typename Identifier, typename Gradient>
+  struct PersistentReservedVector : public AdjointsInterface<Identifier, Gradient> {
+    public:
+      static Gradient* data;
+      static size_t capacity;  /// number of reserved adjoint variables
+      #pragma omp threadprivate(data, capacity)
+
+      Gradient& operator[](Identifier identifier) {
+        return data[identifier];
+      }
+
+      Gradient const& operator[](Identifier identifier) const {
+        return data[identifier];
+      }
+
+      void prefetch(Identifier identifier) const {
+        __builtin_prefetch(data + identifier, 1);
+      }
+
+      void resize(size_t size) {
+        if (size <= capacity) {
+          return;
+        }
+
+        size_t newCapacity = capacity == 0 ? 1 : capacity;
+        while (newCapacity < size) {
+          newCapacity *= 2;
+        }
+
+        void* newData;
+        if (capacity == 0) {
+          newData = mmap(nullptr, newCapacity * sizeof(Gradient), PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        } else {
+          newData = mremap(data, capacity * sizeof(Gradient), newCapacity * sizeof(Gradient), MREMAP_MAYMOVE);
+        }
+        if (newData == MAP_FAILED) {
+          throw std::bad_alloc();
+        }
+
+        data = static_cast<Gradient*>(newData);
+        capacity = newCapacity;
+      }
+
+      /// Release touched pages, which read as zero afterwards.
+      void clear() {
+        if (capacity != 0) {
+          Allocation::recordPlacement(data, capacity * sizeof(Gradient));
+          Memory::recordAdjointBytes(Memory::PERSISTENT_RESERVED_VECTOR,
+                                     Memory::getResidentBytes(data, capacity * sizeof(Gradient)));
+          madvise(data, capacity * sizeof(Gradient), MADV_DONTNEED);
+        }
+      }
+  };
+
+  template<typename Identifier, typename Gradient>
+  Gradient* PersistentReservedVector<Identifier, Gradient>::data = nullptr;
+
+  template<typename Identifier, typename Gradient>
+  size_t PersistentReservedVector<Identifier, Gradient>::capacity = 0;
+
+  /** @brief Persistent two-level vector of adjoint variables (underlying thread-local pages reused across instances).
+   *
+   *  A directory with one entry per pageSize identifiers points to pages of adjoint variables, which are taken from a
+   *  thread-local pool on first access. Memory thus scales with the number of distinct pages that a tape touches
+   *  instead of its identifier span, at the cost of one indirection per access. reset returns the touched pages to
+   *  the pool after each tape. Evaluations auto-zero, so that returned pages need not be cleared.
+   */
+  template<typename Identifier, typename Gradient>
+  struct PersistentPagedVector : public AdjointsInterface<Identifier, Gradient> {
+    public:
+      static size_t const pageBits = 9;
+      static size_t const pageSize = size_t(1) << pageBits;  /// adjoint variables per page
+
+      using Page = std::vector<Gradient, Allocation::Allocator<Gradient>>;
+
+      struct Pages {
+        public:
+          std::vector<Gradient*> directory;  /// per page of identifiers, nullptr if not touched
+          std::vector<size_t> touched;       /// directory indices of the touched pages
+          std::vector<Gradient*> pool;       /// free pages, all zero
+          std::vector<Page> storage;         /// all pages of the thread
+      };
+
+      static Pages* pages;
+      #pragma omp threadprivate(pages)
+
+      Gradient& operator[](Identifier identifier) {
+        size_t index = static_cast<size_t>(identifier) >> pageBits;
+        Gradient* page = pages->directory[index];
+        if (page == nullptr) {
+          page = acquire(index);
+        }
+        return page[static_cast<size_t>(identifier) & (pageSize - 1)];
+      }
+
+      Gradient const& operator[](Identifier identifier) const {
+        size_t index = static_cast<size_t>(identifier) >> pageBits;
+        Gradient* page = pages->directory[index];
+        if (page == nullptr) {
+          page = acquire(index);
+        }
+        return page[static_cast<size_t>(identifier) & (pageSize - 1)];
+      }
+
+      /// Pages of untouched identifiers are not allocated by prefetching.
+      void prefetch(Identifier identifier) const {
+        Gradient* page = pages->directory[static_cast<size_t>(identifier) >> pageBits];
+        if (page != nullptr) {
+          __builtin_prefetch(page + (static_cast<size_t>(identifier) & (pageSize - 1)), 1);
+        }
+      }
+
+      /// Grow the directory, pages are only allocated on access.
+      void resize(size_t size) {
+        size_t nPages = (size + pageSize - 1) >> pageBits;
+        if (nPages > pages->directory.size()) {
+          pages->directory.resize(nPages, nullptr);
+        }
+      }
+
+      /// Return the touched pages to the pool.
+      void reset() {
+        for (auto const& index : pages->touched) {
+          pages->pool.push_back(pages->directory[index]);
+          pages->directory[index] = nullptr;
+        }
+        pages->touched.clear();
+      }
+
+      void clear() {
+        Memory::recordAdjointBytes(Memory::PERSISTENT_PAGED_VECTOR,
+                                   pages->storage.size() * pageSize * sizeof(Gradient) +
+                                       pages->directory.capacity() * sizeof(Gradient*));
+        *pages = Pages();
+      }
+
+    private:
+      /// Map a page from the pool, or a new one if the pool is empty, to the given directory index.
+      static Gradient* acquire(size_t index) {
+        if (pages->pool.empty()) {
+          pages->storage.push_back(Page(pageSize, Gradient()));
+          pages->pool.push_back(pages->storage.back().data());
+        }
+        Gradient* page = pages->pool.back();
+        pages->pool.pop_back();
+        pages->directory[index] = page;
+        pages->touched.push_back(index);
+        return page;
+      }
+  };
+
+  template<typename Identifier, typename Gradient>
+  typename PersistentPagedVector<Identifier, Gradient>::Pages* PersistentPagedVector<Identifier, Gradient>::pages =
+      new typename PersistentPagedVector<Identifier, Gradient>::Pages();
 }
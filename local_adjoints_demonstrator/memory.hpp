@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <omp.h>
+#include <ostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/** @brief Memory accounting of the benchmark runs.
+ *
+ *  Three complementary measures:
+ *  - the high water mark of the process, which is reset to the current resident set size before each run by writing
+ *    to /proc/self/clear_refs, so that it excludes transient memory of the workload generation and earlier runs;
+ *    resetting requires Linux 4.0 and may be denied, e.g., in containers;
+ *  - the resident set size sampled by a background thread at a fixed interval, which shows how memory evolves within
+ *    runs;
+ *  - the peak bytes of each kind of local adjoint container per thread, as reported by the containers themselves, so
+ *    that the memory of the strategies can be told apart from the tapes, the global tape, and the OpenMP runtime.
+ */
+namespace Memory {
+
+  /// Value of the given field of /proc/self/status in MB, 0 if it cannot be read.
+  inline double readStatus(std::string const& field) {
+    std::ifstream process("/proc/self/status");
+    std::string buffer;
+    while (process >> buffer) {
+      if (buffer == field) {
+        size_t kilobytes = 0;
+        process >> kilobytes;
+        return static_cast<double>(kilobytes) / 1024.0;
+      }
+    }
+    return 0.0;
+  }
+
+  /// High water mark of the resident set size of the process in MB.
+  inline double getHighWaterMark() {
+    return readStatus("VmHWM:");
+  }
+
+  /// Resident set size of the process in MB, from /proc/self/statm, which is cheaper to read than the status.
+  inline double getResidentSetSize() {
+    std::ifstream statm("/proc/self/statm");
+    size_t sizePages = 0;
+    size_t residentPages = 0;
+    statm >> sizePages >> residentPages;
+    return static_cast<double>(residentPages) * sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+  }
+
+  /// Reset the high water mark of the process to the current resident set size, returns false if not supported.
+  inline bool resetHighWaterMark() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+    clearRefs.close();
+    return !clearRefs.fail();
+  }
+
+  /// Kinds of local adjoint containers that report their memory.
+  enum Container {
+    TEMPORARY_MAP = 0,               /// std::map and std::unordered_map, estimated from the number of nodes
+    TEMPORARY_VECTOR = 1,
+    PERSISTENT_VECTOR = 2,           /// with and without offset
+    PERSISTENT_FLAT_MAP = 3,
+    PERSISTENT_EPOCH_VECTOR = 4,
+    PERSISTENT_RESERVED_VECTOR = 5,  /// resident pages of the reservation only
+    PERSISTENT_PAGED_VECTOR = 6,     /// directory and pages
+    NUMBER_OF_CONTAINERS = 7
+  };
+
+  inline char const* getContainerName(Container container) {
+    static char const* const names[NUMBER_OF_CONTAINERS] = {"temporary map", "temporary vector", "persistent vector",
+                                                            "flat map", "epoch vector", "reserved vector",
+                                                            "paged vector"};
+    return names[container];
+  }
+
+  /// Peak bytes per kind of container.
+  struct AdjointPeaks {
+    public:
+      size_t bytes[NUMBER_OF_CONTAINERS];
+
+      /// Sum over all kinds, an upper bound of the peak, as containers of different kinds need not coexist.
+      size_t getTotal() const {
+        size_t total = 0;
+        for (auto const& containerBytes : bytes) {
+          total += containerBytes;
+        }
+        return total;
+      }
+  };
+
+  /// Peaks of the calling thread since the last reset.
+  inline AdjointPeaks& getLocalAdjointPeaks() {
+    static AdjointPeaks localPeaks = {};
+    #pragma omp threadprivate(localPeaks)
+    return localPeaks;
+  }
+
+  /// Called by the containers with their current size, at least once it is largest.
+  inline void recordAdjointBytes(Container container, size_t bytes) {
+    size_t& peak = getLocalAdjointPeaks().bytes[container];
+    peak = std::max(peak, bytes);
+  }
+
+  /// Reset the peaks of all threads of the default team.
+  inline void resetAdjointPeaks() {
+    #pragma omp parallel
+    {
+      getLocalAdjointPeaks() = AdjointPeaks();
+    }
+  }
+
+  /// Peaks of all threads of the default team, indexed by OpenMP thread number.
+  inline std::vector<AdjointPeaks> collectAdjointPeaks() {
+    std::vector<AdjointPeaks> peaks(omp_get_max_threads());
+    #pragma omp parallel
+    {
+      peaks[omp_get_thread_num()] = getLocalAdjointPeaks();
+    }
+    return peaks;
+  }
+
+  /// Sum of the total peaks of all threads in MB.
+  inline double getAdjointTotal(std::vector<AdjointPeaks> const& peaks) {
+    double total = 0.0;
+    for (auto const& threadPeaks : peaks) {
+      total += static_cast<double>(threadPeaks.getTotal()) / (1024.0 * 1024.0);
+    }
+    return total;
+  }
+
+  /// Bytes of the resident pages of the given mapping, via mincore.
+  inline size_t getResidentBytes(void* data, size_t bytes) {
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    size_t nPages = (bytes + pageSize - 1) / pageSize;
+    std::vector<unsigned char> residency(nPages);
+    if (nPages == 0 || mincore(data, bytes, residency.data()) != 0) {
+      return 0;
+    }
+    return pageSize * std::count_if(residency.begin(), residency.end(), [](unsigned char page) { return page & 1; });
+  }
+
+  /// Sampling interval of the resident set size in milliseconds, 0 disables sampling.
+  inline size_t& getSamplingInterval() {
+    static size_t interval = 0;
+    return interval;
+  }
+
+  struct Sample {
+    public:
+      double time;  /// seconds since the start of the sampling
+      double rss;   /// resident set size in MB
+  };
+
+  /// Samples the resident set size on a background thread between start and stop.
+  struct Sampler {
+    public:
+      std::thread thread;
+      std::mutex mutex;
+      std::condition_variable stopped;
+      bool running;
+      std::vector<Sample> samples;
+
+      Sampler() : thread(), mutex(), stopped(), running(false), samples() {}
+
+      ~Sampler() {
+        stop();
+      }
+
+      /// Start sampling at the given interval in milliseconds, does nothing for 0.
+      void start(size_t interval) {
+        if (interval == 0) {
+          return;
+        }
+        samples.clear();
+        running = true;
+        thread = std::thread([this, interval]() {
+          auto begin = std::chrono::steady_clock::now();
+          std::unique_lock<std::mutex> lock(mutex);
+          do {
+            double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            samples.push_back(Sample{time, getResidentSetSize()});
+          } while (!stopped.wait_for(lock, std::chrono::milliseconds(interval), [this]() { return !running; }));
+        });
+      }
+
+      /// Stop sampling and return the samples.
+      std::vector<Sample> stop() {
+        if (thread.joinable()) {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = false;
+          }
+          stopped.notify_one();
+          thread.join();
+        }
+        return samples;
+      }
+  };
+
+  inline double getPeak(std::vector<Sample> const& samples) {
+    double peak = 0.0;
+    for (auto const& sample : samples) {
+      peak = std::max(peak, sample.rss);
+    }
+    return peak;
+  }
+
+  /// Report the peaks per thread and kind of container, and the sampled resident set sizes.
+  inline void print(std::ostream& out, std::vector<AdjointPeaks> const& peaks, std::vector<Sample> const& samples) {
+    out << "Peak bytes of local adjoints:" << std::endl;
+    out << std::setw(12) << "thread";
+    for (int container = 0; container < NUMBER_OF_CONTAINERS; ++container) {
+      out << std::setw(18) << getContainerName(static_cast<Container>(container));
+    }
+    out << std::setw(18) << "total" << std::endl;
+    for (size_t thread = 0; thread < peaks.size(); ++thread) {
+      out << std::setw(12) << thread;
+      for (auto const& bytes : peaks[thread].bytes) {
+        out << std::setw(18) << bytes;
+      }
+      out << std::setw(18) << peaks[thread].getTotal() << std::endl;
+    }
+
+    if (!samples.empty()) {
+      double sum = 0.0;
+      for (auto const& sample : samples) {
+        sum += sample.rss;
+      }
+      out << "Resident set size in MB of " << samples.size() << " samples: peak " << getPeak(samples) << ", mean "
+          << sum / samples.size() << std::endl;
+    }
+  }
+}
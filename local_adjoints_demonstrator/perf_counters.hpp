@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <ostream>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+/** @brief Optional per-thread hardware performance counters via perf_event_open.
+ *
+ *  Each thread of the default team opens one counter group for itself, which counts user space events only. Events
+ *  that cannot be opened, e.g., due to perf_event_paranoid, missing hardware support in virtual machines or seccomp
+ *  filters in containers, are reported as unavailable. The groups are kept open across start and stop, which relies on
+ *  the OpenMP runtime reusing the threads of the default team.
+ */
+namespace PerfCounters {
+
+  enum Event {
+    CYCLES = 0,
+    INSTRUCTIONS = 1,
+    L1D_MISSES = 2,     /// L1 data cache read misses
+    LLC_MISSES = 3,     /// last level cache read misses
+    DTLB_MISSES = 4,    /// data TLB read misses
+    BRANCH_MISSES = 5,
+    NUMBER_OF_EVENTS = 6
+  };
+
+  inline char const* getEventName(Event event) {
+    static char const* const names[NUMBER_OF_EVENTS] = {"cycles", "instructions", "L1D misses", "LLC misses",
+                                                        "dTLB misses", "branch misses"};
+    return names[event];
+  }
+
+  inline uint64_t getCacheConfig(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  inline void setEventConfig(Event event, perf_event_attr& attributes) {
+    switch (event) {
+      case CYCLES:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case INSTRUCTIONS:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case L1D_MISSES:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = getCacheConfig(PERF_COUNT_HW_CACHE_L1D);
+        break;
+      case LLC_MISSES:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = getCacheConfig(PERF_COUNT_HW_CACHE_LL);
+        break;
+      case DTLB_MISSES:
+        attributes.type = PERF_TYPE_HW_CACHE;
+        attributes.config = getCacheConfig(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+      default:
+        attributes.type = PERF_TYPE_HARDWARE;
+        attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+  }
+
+  /// Event counts of a thread, scaled up if the group was multiplexed with other events.
+  struct Counts {
+    public:
+      uint64_t values[NUMBER_OF_EVENTS];
+      bool available[NUMBER_OF_EVENTS];  /// whether the event was opened and scheduled
+
+      Counts() : values(), available() {}
+  };
+
+  /// Counter group of a thread, the first event that could be opened is the group leader.
+  struct Group {
+    public:
+      int descriptors[NUMBER_OF_EVENTS];
+      int leader;
+      bool opened;
+
+      Group() : leader(-1), opened(false) {
+        for (int event = 0; event < NUMBER_OF_EVENTS; ++event) {
+          descriptors[event] = -1;
+        }
+      }
+
+      /// Open the events for the calling thread. Events that cannot be opened are skipped.
+      void open() {
+        opened = true;
+        for (int event = 0; event < NUMBER_OF_EVENTS; ++event) {
+          perf_event_attr attributes;
+          std::memset(&attributes, 0, sizeof(attributes));
+          attributes.size = sizeof(attributes);
+          setEventConfig(static_cast<Event>(event), attributes);
+          attributes.disabled = leader == -1 ? 1 : 0;
+          attributes.exclude_kernel = 1;
+          attributes.exclude_hv = 1;
+          attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+          long descriptor = syscall(SYS_perf_event_open, &attributes, 0, -1, leader, 0);
+          if (descriptor >= 0) {
+            descriptors[event] = static_cast<int>(descriptor);
+            if (leader == -1) {
+              leader = descriptors[event];
+            }
+          }
+        }
+      }
+
+      void control(unsigned long request) {
+        if (leader != -1) {
+          ioctl(leader, request, PERF_IOC_FLAG_GROUP);
+        }
+      }
+
+      Counts read() const {
+        Counts counts;
+        for (int event = 0; event < NUMBER_OF_EVENTS; ++event) {
+          uint64_t buffer[3];  // value, time enabled, time running
+          if (descriptors[event] == -1 || ::read(descriptors[event], buffer, sizeof(buffer)) != sizeof(buffer) ||
+              buffer[2] == 0) {
+            continue;
+          }
+          counts.available[event] = true;
+          counts.values[event] = buffer[2] < buffer[1]
+                                     ? static_cast<uint64_t>(static_cast<double>(buffer[0]) * buffer[1] / buffer[2])
+                                     : buffer[0];
+        }
+        return counts;
+      }
+  };
+
+  /// Whether start and stop count anything, disabled by default.
+  inline bool& getEnabled() {
+    static bool enabled = false;
+    return enabled;
+  }
+
+  /// Counter group of the calling thread, opened on first use.
+  inline Group& getLocalGroup() {
+    static Group* localGroup = nullptr;
+    #pragma omp threadprivate(localGroup)
+    if (localGroup == nullptr) {
+      localGroup = new Group();
+    }
+    if (!localGroup->opened) {
+      localGroup->open();
+    }
+    return *localGroup;
+  }
+
+  /// Reset and enable the counters of all threads of the default team, if enabled.
+  inline void start() {
+    if (!getEnabled()) {
+      return;
+    }
+    #pragma omp parallel
+    {
+      Group& group = getLocalGroup();
+      group.control(PERF_EVENT_IOC_RESET);
+      group.control(PERF_EVENT_IOC_ENABLE);
+    }
+  }
+
+  /// Disable the counters of all threads of the default team and return their counts, indexed by OpenMP thread
+  /// number. Empty if not enabled.
+  inline std::vector<Counts> stop() {
+    std::vector<Counts> counts;
+    if (!getEnabled()) {
+      return counts;
+    }
+    counts.resize(omp_get_max_threads());
+    #pragma omp parallel
+    {
+      Group& group = getLocalGroup();
+      group.control(PERF_EVENT_IOC_DISABLE);
+      counts[omp_get_thread_num()] = group.read();
+    }
+    return counts;
+  }
+
+  /// Report event totals over all threads per run and derived ratios, averaged over the given number of runs.
+  inline void print(std::ostream& out, std::vector<Counts> const& counts, size_t nRuns) {
+    double totals[NUMBER_OF_EVENTS] = {};
+    size_t nAvailable[NUMBER_OF_EVENTS] = {};
+    for (auto const& threadCounts : counts) {
+      for (int event = 0; event < NUMBER_OF_EVENTS; ++event) {
+        if (threadCounts.available[event]) {
+          totals[event] += static_cast<double>(threadCounts.values[event]) / nRuns;
+          ++nAvailable[event];
+        }
+      }
+    }
+
+    out << "Hardware counters over all threads per run:" << std::endl;
+    for (int event = 0; event < NUMBER_OF_EVENTS; ++event) {
+      out << std::setw(16) << getEventName(static_cast<Event>(event));
+      if (nAvailable[event] == 0) {
+        out << std::setw(16) << "unavailable" << std::endl;
+      } else {
+        out << std::setw(16) << totals[event];
+        if (nAvailable[event] < counts.size()) {
+          out << " (" << nAvailable[event] << " of " << counts.size() << " threads)";
+        }
+        out << std::endl;
+      }
+    }
+
+    if (nAvailable[CYCLES] != 0 && nAvailable[INSTRUCTIONS] != 0 && totals[CYCLES] > 0.0) {
+      out << std::setw(16) << "IPC" << std::setw(16) << totals[INSTRUCTIONS] / totals[CYCLES] << std::endl;
+    }
+  }
+}
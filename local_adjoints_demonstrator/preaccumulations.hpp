@@ -1,8 +1,24 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <omp.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
 #include "evaluation_strategies.hpp"
+#include "global_tape.hpp"
+#include "instrumentation.hpp"
 #include "local_adjoints.hpp"
+#include "scheduling.hpp"
+#include "span.hpp"
+#include "statement_tape.hpp"
 #include "tape.hpp"
+#include "trace.hpp"
+#include "workload.hpp"
 
 /// Emulates simultaneous preaccumulations in multiple threads.
 template<typename Identifier, typename Gradient>
@@ -16,43 +32,461 @@ struct Preaccumulations {
     Identifier iMin;
     Identifier iMax;
     size_t randomSeed;
+    size_t vectorWidth;                      /// number of seeds propagated per tape evaluation, 1 for scalar mode
+    bool keepRemapped;                       /// whether editing strategies keep stored tapes remapped across runs
+    Scheduling::Schedule schedule;           /// distribution of work items across threads
+    size_t chunkSize;                        /// chunk size of the OpenMP schedules, 0 for the default
+    double loadImbalance;                    /// maximum over mean busy time of the threads in the last run
+    Generators::Parameters identifierModel;  /// distribution of the identifiers of generated tapes
+    bool statementTapes;                     /// whether to generate statement tapes instead of chains
+    StatementShape statementShape;           /// shape of generated statement tapes
+    EvaluationStrategy::Mode mode;           /// direction of the sweeps, or per work item the one with fewer sweeps
+    size_t nInputsMin;                       /// minimum number of inputs, i.e., of forward sweeps, per work item
+    size_t nInputsMax;                       /// maximum number of inputs, the number of evaluations is that of outputs
+    size_t nForwardItems;                    /// work items evaluated in forward mode in the last run
+    double sweepSavings;                     /// fraction of swept tape entries saved compared to reverse mode
+    double splitThreshold;                   /// tape entries times seeds above which work items are split, 0 never
+    size_t nSplitItems;                      /// work items split into tasks in the last run
+    std::vector<double> taskTimes;           /// per thread, seconds spent in tasks of split work items in a run
+
+    Workload<Identifier, Gradient> workload;              /// pregenerated work items, empty if generated during runs
+    Trace::MappedTrace<Identifier, Gradient> trace;       /// replayed work items, empty unless replaying a trace
+    Scheduling::CostModelQueues costModelQueues;          /// planned per number of threads for the cost model schedule
+    GlobalTape::Buffer<Identifier, Gradient> globalTape;  /// results of the work items of the last run, if enabled
+
+    /// Per-thread buffers, reused across work items, and per-thread counts of the mode choice.
+    struct ItemBuffers {
+      public:
+        Tape<Identifier, Gradient> tape;                 /// generated tapes, or copies of stored tapes for editing
+        StatementTape<Identifier, Gradient> statements;  /// generated statement tapes
+        std::vector<Identifier> inputs;                  /// inputs of the current result for the global tape
+        std::vector<Identifier> outputs;                 /// outputs of the current result for the global tape
+        std::vector<Gradient> jacobian;                  /// Jacobian of the current result for the global tape
+        size_t nForwardItems;                            /// work items evaluated in forward mode
+        double sweptEntries;                             /// tape entries times sweeps in the chosen modes
+        double reverseEntries;                           /// tape entries times sweeps in reverse mode
+        size_t nSplitItems;                              /// work items split into tasks
+
+        ItemBuffers() : nForwardItems(0), sweptEntries(0.0), reverseEntries(0.0), nSplitItems(0) {}
+    };
 
     Preaccumulations(size_t nPreaccs, size_t preaccSizeMin, size_t preaccSizeMax, size_t nEvalMin, size_t nEvalMax,
                      Identifier iMin, Identifier iMax, size_t randomSeed)
         : nPreaccs(nPreaccs), preaccSizeMin(preaccSizeMin), preaccSizeMax(preaccSizeMax), nEvalMin(nEvalMin),
-          nEvalMax(nEvalMax), iMin(iMin), iMax(iMax), randomSeed(randomSeed) {}
+          nEvalMax(nEvalMax), iMin(iMin), iMax(iMax), randomSeed(randomSeed), vectorWidth(1), keepRemapped(false),
+          schedule(Scheduling::STATIC), chunkSize(0), loadImbalance(1.0), identifierModel(), statementTapes(false),
+          statementShape(), mode(EvaluationStrategy::REVERSE), nInputsMin(nEvalMin), nInputsMax(nEvalMax),
+          nForwardItems(0), sweepSavings(0.0), splitThreshold(0.0), nSplitItems(0), taskTimes(),
+          workload(), trace(), costModelQueues(), globalTape() {}
+
+    /// Vector widths for which vector mode evaluations are instantiated.
+    static bool isSupportedVectorWidth(size_t width) {
+      return width == 1 || width == 4 || width == 8 || width == 16;
+    }
+
+    /// Draw the tape size, the number of evaluations, and the random seed for the tape of work item i.
+    void drawItem(size_t i, size_t& size, size_t& nEval, size_t& tapeSeed) const {
+      // produce a random seed specific to this preaccumulation
+      std::mt19937 preaccSeedGenerator(randomSeed + i);
+      tapeSeed = preaccSeedGenerator();
+
+      std::mt19937 generator(tapeSeed);
+      std::uniform_int_distribution<size_t> preaccSizeDistribution(preaccSizeMin, preaccSizeMax);
+      size = preaccSizeDistribution(generator);
+      std::uniform_int_distribution<size_t> nEvalDistribution(nEvalMin, nEvalMax);
+      nEval = nEvalDistribution(generator);
+    }
+
+    /// Draw the number of inputs of work item i, separately from drawItem, whose draws are the same in all modes.
+    size_t drawNumberOfInputs(size_t i) const {
+      std::mt19937 generator(Generators::mix(randomSeed + i));
+      std::uniform_int_distribution<size_t> nInputsDistribution(nInputsMin, nInputsMax);
+      return nInputsDistribution(generator);
+    }
+
+    /// Seed of the identifier set that work item i shares with its neighbours in the SHARED identifier model.
+    uint64_t getGroupSeed(size_t i) const {
+      return Generators::mix(randomSeed) + i / std::max<size_t>(identifierModel.groupSize, 1);
+    }
+
+    /// Generate all work items once in contiguous memory. Subsequent runs evaluate the stored tapes, so that the
+    /// generation is no longer part of their runtime. The workload is identical to the one generated during runs.
+    /// Throws std::invalid_argument for statement tapes.
+    void pregenerate() {
+      if (statementTapes) {
+        throw std::invalid_argument("Statement tapes are generated during runs only.");
+      }
+      std::vector<size_t> sizes(nPreaccs);
+      std::vector<size_t> nEvals(nPreaccs);
+      std::vector<size_t> tapeSeeds(nPreaccs);
+
+      #pragma omp parallel for
+      for (size_t i = 0; i < nPreaccs; ++i) {
+        drawItem(i, sizes[i], nEvals[i], tapeSeeds[i]);
+      }
+
+      workload.resize(sizes, nEvals);
+
+      #pragma omp parallel for
+      for (size_t i = 0; i < nPreaccs; ++i) {
+        Tape<Identifier, Gradient>::generate(workload.identifiers.data() + workload.offsets[i],
+                                             workload.jacobians.data() + workload.offsets[i], sizes[i], iMin, iMax,
+                                             tapeSeeds[i], identifierModel, getGroupSeed(i));
+      }
+    }
+
+    /// Write the work items to a trace file, generated as during runs or from the pregenerated workload.
+    /// Throws std::runtime_error if the trace cannot be written, std::invalid_argument for statement tapes.
+    void record(std::string const& path) {
+      if (statementTapes) {
+        throw std::invalid_argument("Traces of statement tapes are not supported.");
+      }
+      Trace::Recorder<Identifier, Gradient> recorder(path);
+      Tape<Identifier, Gradient> tapeBuffer;
+      for (size_t i = 0; i < nPreaccs; ++i) {
+        if (workload.size() == 0) {
+          size_t size, nEval, tapeSeed;
+          drawItem(i, size, nEval, tapeSeed);
+          tapeBuffer.generateInPlace(size, iMin, iMax, tapeSeed, identifierModel, getGroupSeed(i));
+          recorder.record(tapeBuffer, nEval);
+        } else {
+          recorder.record(workload.getTape(i), workload.getNumberOfEvaluations(i));
+        }
+      }
+      recorder.close();
+    }
+
+    /// Replay the work items of a trace file instead of generating them. Tape sizes and numbers of evaluations are
+    /// taken from the trace, the numbers of inputs default to the range of the latter. Throws std::runtime_error if the
+    /// trace cannot be read.
+    void replay(std::string const& path, bool streaming) {
+      workload.clear();
+      trace.open(path, streaming);
+
+      nPreaccs = trace.size();
+      preaccSizeMin = nEvalMin = std::numeric_limits<size_t>::max();
+      preaccSizeMax = nEvalMax = 0;
+      for (size_t i = 0; i < nPreaccs; ++i) {
+        preaccSizeMin = std::min(preaccSizeMin, trace.getTapeSize(i));
+        preaccSizeMax = std::max(preaccSizeMax, trace.getTapeSize(i));
+        nEvalMin = std::min(nEvalMin, trace.getNumberOfEvaluations(i));
+        nEvalMax = std::max(nEvalMax, trace.getNumberOfEvaluations(i));
+      }
+      if (nPreaccs == 0) {
+        preaccSizeMin = nEvalMin = 0;
+      }
+      nInputsMin = nEvalMin;
+      nInputsMax = nEvalMax;
+      costModelQueues = Scheduling::CostModelQueues();
+    }
 
-    /// Run simultaneous preaccumulations with the specified evaluation strategy.
+    /// Run simultaneous preaccumulations with the specified evaluation strategy, in scalar or vector mode.
     template<EvaluationStrategy::Strategy evaluationStrategy>
     Gradient run(Gradient const& seed) {
+      using EvaluationStrategy::ScalarSweeps;
+      using EvaluationStrategy::VectorSweeps;
+
+      switch (vectorWidth) {
+        case 1:
+          return runSweeps<evaluationStrategy, ScalarSweeps<Gradient>>(seed);
+        case 4:
+          return runSweeps<evaluationStrategy, VectorSweeps<Gradient, 4>>(seed);
+        case 8:
+          return runSweeps<evaluationStrategy, VectorSweeps<Gradient, 8>>(seed);
+        case 16:
+          return runSweeps<evaluationStrategy, VectorSweeps<Gradient, 16>>(seed);
+        default:
+          throw std::invalid_argument("Unsupported vector width " + std::to_string(vectorWidth) + ".");
+      }
+    }
+
+    /// Estimated cost of work item i, proportional to its tape size times its number of evaluations.
+    double estimateCost(size_t i) const {
+      if (trace.size() != 0) {
+        return static_cast<double>(trace.getTapeSize(i)) * trace.getNumberOfEvaluations(i);
+      } else if (workload.size() != 0) {
+        return static_cast<double>(workload.getTapeSize(i)) * workload.getNumberOfEvaluations(i);
+      } else {
+        size_t size, nEval, tapeSeed;
+        drawItem(i, size, nEval, tapeSeed);
+        return static_cast<double>(size) * nEval;
+      }
+    }
+
+    /// Plan the cost model queues for the given number of threads, unless they are already planned.
+    void planCostModel(size_t nThreads) {
+      if (costModelQueues.getNumberOfThreads() == nThreads && costModelQueues.order.size() == nPreaccs) {
+        costModelQueues.rewind();
+        return;
+      }
+
+      std::vector<double> costs(nPreaccs);
+      #pragma omp parallel for
+      for (size_t i = 0; i < nPreaccs; ++i) {
+        costs[i] = estimateCost(i);
+      }
+      costModelQueues.plan(costs, nThreads);
+    }
+
+    /// Store the result of a work item in the global tape, as the Jacobian of the outputs with respect to the inputs
+    /// captured before the evaluation. The sweeps only return the sum of all entries weighted by the seeds, so each
+    /// entry is set to the mean entry.
+    void pushResult(ItemBuffers& buffers, Gradient result, Span<Gradient const> seeds) {
+      Gradient seedSum = std::accumulate(seeds.begin(), seeds.end(), Gradient(0.0));
+      size_t nEntries = buffers.inputs.size() * buffers.outputs.size();
+      buffers.jacobian.assign(nEntries, seedSum != 0.0 ? result / (seedSum * nEntries) : Gradient(0.0));
+      globalTape.push(buffers.inputs, buffers.outputs, buffers.jacobian);
+    }
+
+    /** @brief Evaluate a tape with the given seeds, split into OpenMP tasks if its size times the number of seeds
+     *  exceeds the split threshold.
+     *
+     *  The seeds are divided into groups of whole sweeps of about splitThreshold cost each. Each group is evaluated in
+     *  a task with the local adjoints of the thread that executes it, threads that are done with their work items pick
+     *  up tasks at the barrier after the loop. Group results are summed in seed order. For editing strategies, the
+     *  first group is evaluated before the tasks are created, so that the tape is remapped once before the other groups
+     *  read it concurrently. The adaptive strategy chooses its path once for all groups. Tasks add their runtime to
+     *  the task time of the executing thread, so that tasks run at the barrier count as busy time.
+     */
+    template<EvaluationStrategy::Strategy evaluationStrategy, typename Sweeps, typename TapeType>
+    Gradient evaluateSeeds(TapeType& tape, Span<Gradient const> seeds, ItemBuffers& buffers) {
+      size_t nSweeps = (seeds.size() + Sweeps::seedsPerSweep - 1) / Sweeps::seedsPerSweep;
+      double cost = static_cast<double>(tape.identifiers.size()) * seeds.size();
+      size_t nGroups = 1;
+      if (splitThreshold > 0.0 && cost > splitThreshold) {
+        nGroups = std::min(nSweeps, static_cast<size_t>(std::ceil(cost / splitThreshold)));
+      }
+      if (nGroups <= 1) {
+        return EvaluationStrategy::evaluate<Identifier, Gradient, evaluationStrategy, Sweeps>(tape, seeds);
+      }
+      ++buffers.nSplitItems;
+
+      // the first nSweeps % nGroups groups have one sweep more
+      auto getGroup = [&](size_t group) {
+        size_t begin = group * (nSweeps / nGroups) + std::min(group, nSweeps % nGroups);
+        size_t end = begin + nSweeps / nGroups + (group < nSweeps % nGroups ? 1 : 0);
+        begin *= Sweeps::seedsPerSweep;
+        end = std::min(end * Sweeps::seedsPerSweep, seeds.size());
+        return Span<Gradient const>(seeds.data() + begin, end - begin);
+      };
+
+      EvaluationStrategy::GroupEvaluation<Identifier, Gradient, evaluationStrategy, Sweeps> evaluation(tape,
+                                                                                                      seeds.size());
+      std::vector<Gradient> groupResults(nGroups);
+      bool editing = evaluation.isEditing();
+      if (editing) {
+        groupResults[0] = evaluation.evaluate(tape, getGroup(0));
+      }
+      for (size_t group = 1; group < nGroups; ++group) {
+        #pragma omp task default(shared) firstprivate(group)
+        {
+          auto start = Instrumentation::Clock::now();
+          groupResults[group] = evaluation.evaluate(tape, getGroup(group));
+          taskTimes[omp_get_thread_num()] += Instrumentation::getSeconds(start, Instrumentation::Clock::now());
+        }
+      }
+      if (!editing) {
+        groupResults[0] = evaluation.evaluate(tape, getGroup(0));
+      }
+      #pragma omp taskwait
+
+      return std::accumulate(groupResults.begin(), groupResults.end(), Gradient(0.0));
+    }
+
+    /// Evaluate the tape of work item i with nEval outputs in reverse or forward mode, and store its result in the
+    /// global tape, if enabled. Inputs and outputs are captured before the evaluation, as editing strategies remap the
+    /// identifiers of the tape.
+    template<EvaluationStrategy::Strategy evaluationStrategy, typename Sweeps, typename TapeType>
+    Gradient evaluateItem(size_t i, TapeType& tape, std::vector<Gradient> const& allSeeds, size_t nEval,
+                          ItemBuffers& buffers) {
+      bool forward = false;
+      size_t nSeeds = nEval;
+      if (mode != EvaluationStrategy::REVERSE) {
+        size_t nInputs = drawNumberOfInputs(i);
+        size_t nReverseSweeps = (nEval + Sweeps::seedsPerSweep - 1) / Sweeps::seedsPerSweep;
+        size_t nForwardSweeps = (nInputs + Sweeps::seedsPerSweep - 1) / Sweeps::seedsPerSweep;
+        forward = mode == EvaluationStrategy::FORWARD || nForwardSweeps < nReverseSweeps;
+        if (forward) {
+          nSeeds = nInputs;
+          ++buffers.nForwardItems;
+        }
+        double tapeSize = static_cast<double>(tape.identifiers.size());
+        buffers.sweptEntries += (forward ? nForwardSweeps : nReverseSweeps) * tapeSize;
+        buffers.reverseEntries += nReverseSweeps * tapeSize;
+      }
+      Span<Gradient const> seeds(allSeeds.data(), nSeeds);
+
+      if (globalTape.scheme != GlobalTape::NONE) {
+        Instrumentation::ScopedTimer timer(Instrumentation::PUSH);
+        buffers.inputs.assign(tape.getInputs().begin(), tape.getInputs().end());
+        buffers.outputs.assign(tape.getOutputs().begin(), tape.getOutputs().end());
+      }
+
+      Gradient result;
+      {
+        Instrumentation::ScopedTimer timer(Instrumentation::EVALUATION);
+        if (forward) {
+          result = evaluateSeeds<evaluationStrategy, typename Sweeps::ForwardSweeps>(tape, seeds, buffers);
+        } else {
+          result = evaluateSeeds<evaluationStrategy, Sweeps>(tape, seeds, buffers);
+        }
+      }
+
+      if (globalTape.scheme != GlobalTape::NONE) {
+        Instrumentation::ScopedTimer timer(Instrumentation::PUSH);
+        pushResult(buffers, result, seeds);
+      }
+      return result;
+    }
+
+    /// Process stored work item i, either evaluated in place or, for editing strategies, copied to the tape buffer
+    /// unless remapped tapes are kept.
+    template<EvaluationStrategy::Strategy evaluationStrategy, typename Sweeps, typename Storage>
+    Gradient runStoredItem(size_t i, Storage& storage, bool editInPlace, std::vector<Gradient> const& seeds,
+                           ItemBuffers& buffers) {
+      auto tape = storage.getTape(i);
+      size_t nEval = storage.getNumberOfEvaluations(i);
+
+      if (EvaluationStrategy::isEditing(evaluationStrategy) && !editInPlace) {
+        {
+          Instrumentation::ScopedTimer timer(Instrumentation::GENERATION);
+          buffers.tape.identifiers.assign(tape.identifiers.begin(), tape.identifiers.end());
+          buffers.tape.jacobians.assign(tape.jacobians.begin(), tape.jacobians.end());
+          buffers.tape.remapped = tape.remapped;
+        }
+        return evaluateItem<evaluationStrategy, Sweeps>(i, buffers.tape, seeds, nEval, buffers);
+      } else {
+        Gradient result = evaluateItem<evaluationStrategy, Sweeps>(i, tape, seeds, nEval, buffers);
+        storage.remapped[i] = tape.remapped;
+        return result;
+      }
+    }
+
+    /// Process work item i with the specified evaluation strategy and sweeps. Tapes are generated into or copied to the
+    /// given per-thread buffers, so that no allocations are required once the buffers have grown to the largest tape.
+    template<EvaluationStrategy::Strategy evaluationStrategy, typename Sweeps>
+    Gradient runItem(size_t i, std::vector<Gradient> const& seeds, ItemBuffers& buffers) {
+      if (trace.size() != 0) {
+        trace.willNeed(i + 1);
+        Gradient result = runStoredItem<evaluationStrategy, Sweeps>(i, trace, keepRemapped && !trace.streaming, seeds,
+                                                                    buffers);
+        trace.dontNeed(i);
+        return result;
+      } else if (workload.size() != 0) {
+        return runStoredItem<evaluationStrategy, Sweeps>(i, workload, keepRemapped, seeds, buffers);
+      } else if (statementTapes) {
+        size_t nEval;
+        {
+          Instrumentation::ScopedTimer timer(Instrumentation::GENERATION);
+          size_t size, tapeSeed;
+          drawItem(i, size, nEval, tapeSeed);
+          buffers.statements.generateInPlace(size, statementShape, iMin, iMax, tapeSeed, identifierModel,
+                                             getGroupSeed(i));
+        }
+
+        return evaluateItem<evaluationStrategy, Sweeps>(i, buffers.statements, seeds, nEval, buffers);
+      } else {
+        // generate a tape, mimicking the preaccumulation-associated recording
+        size_t nEval;
+        {
+          Instrumentation::ScopedTimer timer(Instrumentation::GENERATION);
+          size_t size, tapeSeed;
+          drawItem(i, size, nEval, tapeSeed);
+          buffers.tape.generateInPlace(size, iMin, iMax, tapeSeed, identifierModel, getGroupSeed(i));
+        }
+
+        // evaluate the tape, possibly multiple times to emulate multiple preaccumulation inputs/outputs
+        return evaluateItem<evaluationStrategy, Sweeps>(i, buffers.tape, seeds, nEval, buffers);
+      }
+    }
+
+    /// Run simultaneous preaccumulations with the specified evaluation strategy and sweeps.
+    template<EvaluationStrategy::Strategy evaluationStrategy, typename Sweeps>
+    Gradient runSweeps(Gradient const& seed) {
+      // seeds to emulate multiple preaccumulation inputs/outputs, each work item uses as many as it has evaluations, or
+      // inputs in forward mode
+      std::vector<Gradient> seeds(mode == EvaluationStrategy::REVERSE ? nEvalMax : std::max(nEvalMax, nInputsMax));
+      for (size_t i = 0; i < seeds.size(); ++i) {
+        seeds[i] = seed + 0.1 * std::sin(i);
+      }
+
+      if (schedule == Scheduling::COST_MODEL) {
+        planCostModel(omp_get_max_threads());
+      } else {
+        Scheduling::setRuntimeSchedule(schedule, chunkSize);
+      }
+
+      if (globalTape.scheme != GlobalTape::NONE) {
+        size_t nInputs = statementTapes ? statementShape.nInputs : 1;
+        size_t nOutputs = statementTapes ? statementShape.nOutputs : 1;
+        globalTape.clear(omp_get_max_threads(), GlobalTape::getRecordSize<Identifier, Gradient>(nInputs, nOutputs));
+      }
+
+      std::vector<double> busyTimes(omp_get_max_threads(), 0.0);
+      taskTimes.assign(omp_get_max_threads(), 0.0);
+      size_t nThreads = 1;
+
       Gradient result = 0.0;
+      size_t nForward = 0;
+      double sweptEntries = 0.0;
+      double reverseEntries = 0.0;
+      size_t nSplit = 0;
 
-      #pragma omp parallel
+      #pragma omp parallel reduction(+:result, nForward, sweptEntries, reverseEntries, nSplit)
       {
-        #pragma omp for reduction(+:result)
-        for (size_t i = 0; i < nPreaccs; ++i) {
-          // produce a random seed specific to this preaccumulation
-          std::mt19937 preaccSeedGenerator(randomSeed + i);
-          size_t preaccSeed = preaccSeedGenerator();
-
-          // generate a tape, mimicking the preaccumulation-associated recording
-          std::mt19937 generator(preaccSeed);
-          std::uniform_int_distribution<size_t> preaccSizeDistribution(preaccSizeMin, preaccSizeMax);
-          auto tape = Tape<Identifier, Gradient>::generate(preaccSizeDistribution(generator), iMin, iMax, preaccSeed);
-
-          // evaluate the tape, possibly multiple times to emulate multiple preaccumulation inputs/outputs
-          std::uniform_int_distribution<size_t> nEvalDistribution(nEvalMin, nEvalMax);
-          size_t nEval = nEvalDistribution(generator);
-          std::list<Gradient> seeds;
-          for (size_t i = 0; i < nEval; ++i) {
-            seeds.push_back(seed + 0.1 * std::sin(i));
+        size_t thread = omp_get_thread_num();
+        ItemBuffers buffers;
+        Instrumentation::LoopTimer loopTimer;
+        auto start = Instrumentation::Clock::now();
+
+        if (schedule == Scheduling::COST_MODEL) {
+          size_t i;
+          while (costModelQueues.next(thread, i)) {
+            result += runItem<evaluationStrategy, Sweeps>(i, seeds, buffers);
+          }
+        } else {
+          #pragma omp for schedule(runtime) nowait
+          for (size_t i = 0; i < nPreaccs; ++i) {
+            result += runItem<evaluationStrategy, Sweeps>(i, seeds, buffers);
           }
-          result += EvaluationStrategy::evaluate<Identifier, Gradient, evaluationStrategy>(*tape, seeds);
         }
 
-        EvaluationStrategy::clearAdjoints<Identifier, Gradient, evaluationStrategy>();
+        busyTimes[thread] = Instrumentation::getSeconds(start, Instrumentation::Clock::now());
+        nForward += buffers.nForwardItems;
+        sweptEntries += buffers.sweptEntries;
+        reverseEntries += buffers.reverseEntries;
+        nSplit += buffers.nSplitItems;
+        double loopTaskTime = taskTimes[thread];
+        loopTimer.loopDone();
+        #pragma omp barrier
+        // tasks of split work items that this thread ran at the barrier, tasks run in the loop are part of busyTimes
+        double barrierTaskTime = taskTimes[thread] - loopTaskTime;
+        busyTimes[thread] += barrierTaskTime;
+        loopTimer.barrierDone(barrierTaskTime);
+
+        {
+          Instrumentation::ScopedTimer timer(Instrumentation::PUSH);
+          globalTape.merge();
+        }
+
+        #pragma omp single nowait
+        nThreads = omp_get_num_threads();
+
+        {
+          Instrumentation::ScopedTimer timer(Instrumentation::CLEAR);
+          EvaluationStrategy::clearAdjoints<Identifier, Gradient, evaluationStrategy, Sweeps>();
+        }
+        Instrumentation::flush();
       }
 
+      // ratio of the maximum to the mean busy time, 1 for perfect balance
+      double busyMax = *std::max_element(busyTimes.begin(), busyTimes.begin() + nThreads);
+      double busySum = std::accumulate(busyTimes.begin(), busyTimes.begin() + nThreads, 0.0);
+      loadImbalance = busySum > 0.0 ? busyMax * nThreads / busySum : 1.0;
+      nForwardItems = nForward;
+      sweepSavings = reverseEntries > 0.0 ? 1.0 - sweptEntries / reverseEntries : 0.0;
+      nSplitItems = nSplit;
+
       return result;
     }
 };
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <omp.h>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/// Distribution of work items across the threads of simultaneous preaccumulations.
+namespace Scheduling {
+
+  enum Schedule {
+    STATIC = 0,      /// OpenMP static schedule
+    DYNAMIC = 1,     /// OpenMP dynamic schedule
+    GUIDED = 2,      /// OpenMP guided schedule
+    COST_MODEL = 3,  /// longest estimated cost first, per-thread queues with work stealing
+  };
+
+  /// Set the schedule of loops with schedule(runtime). A chunk size of zero selects the OpenMP default.
+  inline void setRuntimeSchedule(Schedule schedule, size_t chunkSize) {
+    omp_sched_t kind = omp_sched_static;
+    if (schedule == DYNAMIC) {
+      kind = omp_sched_dynamic;
+    } else if (schedule == GUIDED) {
+      kind = omp_sched_guided;
+    }
+    omp_set_schedule(kind, static_cast<int>(chunkSize));
+  }
+
+  /** @brief Per-thread queues of work items, planned by estimated cost.
+   *
+   *  Items are assigned longest-first to the thread with the smallest estimated load so far. Each thread processes its
+   *  own queue in order of decreasing cost and then steals the remaining items of the other queues.
+   */
+  struct CostModelQueues {
+    private:
+      /// Position in a queue, padded to a cache line to avoid false sharing between threads.
+      struct Cursor {
+        public:
+          std::atomic<size_t> next;
+          char padding[64 - sizeof(std::atomic<size_t>)];
+
+          Cursor() : next(0) {}
+
+          Cursor(Cursor const& other) : next(other.next.load(std::memory_order_relaxed)) {}
+      };
+
+    public:
+      std::vector<size_t> order;   /// work items, grouped by thread
+      std::vector<size_t> starts;  /// start of each thread's group in order, followed by the number of items
+      std::vector<Cursor> cursors;
+
+      size_t getNumberOfThreads() const {
+        return starts.empty() ? 0 : starts.size() - 1;
+      }
+
+      /// Plan queues for the given number of threads from the estimated cost of each work item.
+      void plan(std::vector<double> const& costs, size_t nThreads) {
+        std::vector<size_t> items(costs.size());
+        for (size_t i = 0; i < items.size(); ++i) {
+          items[i] = i;
+        }
+        std::sort(items.begin(), items.end(), [&](size_t a, size_t b) {
+          return costs[a] > costs[b] || (costs[a] == costs[b] && a < b);
+        });
+
+        using Load = std::pair<double, size_t>;  // estimated load and thread
+        std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+        for (size_t thread = 0; thread < nThreads; ++thread) {
+          loads.push(Load(0.0, thread));
+        }
+
+        std::vector<std::vector<size_t>> queues(nThreads);
+        for (size_t item : items) {
+          Load load = loads.top();
+          loads.pop();
+          queues[load.second].push_back(item);
+          loads.push(Load(load.first + costs[item], load.second));
+        }
+
+        order.clear();
+        starts.resize(nThreads + 1);
+        for (size_t thread = 0; thread < nThreads; ++thread) {
+          starts[thread] = order.size();
+          order.insert(order.end(), queues[thread].begin(), queues[thread].end());
+        }
+        starts[nThreads] = order.size();
+
+        cursors.resize(nThreads);
+        rewind();
+      }
+
+      /// Refill all queues for another pass over the planned items. Not thread-safe.
+      void rewind() {
+        for (size_t thread = 0; thread < getNumberOfThreads(); ++thread) {
+          cursors[thread].next.store(starts[thread], std::memory_order_relaxed);
+        }
+      }
+
+      /// Take the next item for the given thread, from its own queue or stolen from another one.
+      /// Returns false if all queues are empty.
+      bool next(size_t thread, size_t& item) {
+        size_t nThreads = getNumberOfThreads();
+        for (size_t offset = 0; offset < nThreads; ++offset) {
+          size_t queue = (thread + offset) % nThreads;
+          std::atomic<size_t>& next = cursors[queue].next;
+          if (next.load(std::memory_order_relaxed) >= starts[queue + 1]) {
+            continue;
+          }
+          size_t position = next.fetch_add(1, std::memory_order_relaxed);
+          if (position < starts[queue + 1]) {
+            item = order[position];
+            return true;
+          }
+        }
+        return false;
+      }
+  };
+}
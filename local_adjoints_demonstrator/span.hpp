@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+/// Non-owning view of contiguous memory.
+template<typename T>
+struct Span {
+  public:
+    using Value = typename std::remove_const<T>::type;
+
+    T* pointer;
+    size_t length;
+
+    Span() : pointer(nullptr), length(0) {}
+
+    Span(T* pointer, size_t length) : pointer(pointer), length(length) {}
+
+    Span(std::vector<Value>& vector) : pointer(vector.data()), length(vector.size()) {}
+
+    Span(std::vector<Value> const& vector) : pointer(vector.data()), length(vector.size()) {}
+
+    T& operator[](size_t i) const {
+      return pointer[i];
+    }
+
+    T& back() const {
+      return pointer[length - 1];
+    }
+
+    T* begin() const {
+      return pointer;
+    }
+
+    T* end() const {
+      return pointer + length;
+    }
+
+    T* data() const {
+      return pointer;
+    }
+
+    size_t size() const {
+      return length;
+    }
+};
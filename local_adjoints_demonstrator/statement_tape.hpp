@@ -0,0 +1,263 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "generators.hpp"
+#include "tape.hpp"
+
+/// Shape of generated statement tapes.
+struct StatementShape {
+  public:
+    size_t nInputs;       /// number of distinct inputs
+    size_t nOutputs;      /// number of outputs, at most the number of distinct left-hand sides
+    size_t maxArguments;  /// the number of arguments per statement is drawn uniformly from [1, maxArguments]
+    size_t window;        /// each argument is one of the last window variables with probability 1/2, else any
+
+    StatementShape() : nInputs(4), nOutputs(4), maxArguments(2), window(8) {}
+};
+
+/** @brief Statement-based Jacobian tape with multiple inputs and outputs.
+ *
+ *  Resembles the tape of a Jacobian taping AD tool. Each statement assigns to its left-hand side a value that depends
+ *  on a variable number of arguments, the tape stores the partial derivatives with respect to the arguments. The
+ *  statements form a DAG between the inputs and the outputs.
+ *
+ *  identifiers holds the inputs, then per statement its left-hand side followed by its arguments, then the outputs.
+ *  As all identifiers are stored in one array, the identifier editing of BasicTape applies unchanged.
+ *
+ *  Identifiers, Jacobians and argument counts are stored in arrays of the given types, either owning (StatementTape)
+ *  or not (compacted tapes).
+ */
+template<typename Identifier, typename Gradient, typename IdentifierArray, typename JacobianArray,
+         typename CountArray>
+struct BasicStatementTape : public BasicTape<Identifier, Gradient, IdentifierArray, JacobianArray> {
+  public:
+    using Base = BasicTape<Identifier, Gradient, IdentifierArray, JacobianArray>;
+
+    CountArray argumentCounts;  /// number of arguments per statement
+    size_t nInputs;
+    size_t nOutputs;
+
+    BasicStatementTape() : Base(), argumentCounts(), nInputs(0), nOutputs(0) {}
+
+    BasicStatementTape(IdentifierArray const& identifiers, JacobianArray const& jacobians, bool remapped,
+                       CountArray const& argumentCounts, size_t nInputs, size_t nOutputs)
+        : Base(identifiers, jacobians, remapped), argumentCounts(argumentCounts), nInputs(nInputs),
+          nOutputs(nOutputs) {}
+
+    /// Performs a reverse evaluation, seeding all outputs with the given seed, and returns the sum of the adjoints of
+    /// the inputs. Adjoints of arguments are accumulated, adjoints of left-hand sides are reset after use, which is
+    /// required for identifiers that are reassigned within the tape. Auto-zeroing refers to the adjoints of the inputs,
+    /// all other adjoint variables are zero again after the evaluation.
+    template<bool autoZero = true, typename Adjoints, typename Adjoint>
+    Adjoint evaluate(Adjoints& adjoints, Adjoint const& seed) {
+      auto const& identifiers = this->identifiers;
+      auto const& jacobians = this->jacobians;
+
+      size_t identifierPosition = identifiers.size() - nOutputs;
+      for (size_t i = identifierPosition; i < identifiers.size(); ++i) {
+        adjoints[identifiers[i]] += seed;
+      }
+
+      size_t jacobianPosition = jacobians.size();
+      for (size_t statement = argumentCounts.size(); statement-- > 0;) {
+        size_t nArguments = argumentCounts[statement];
+        identifierPosition -= nArguments + 1;
+        jacobianPosition -= nArguments;
+
+        Identifier lhs = identifiers[identifierPosition];
+        Adjoint lhsAdjoint = adjoints[lhs];
+        adjoints[lhs] = 0.0;
+        for (size_t argument = 0; argument < nArguments; ++argument) {
+          Identifier argumentIdentifier = identifiers[identifierPosition + 1 + argument];
+          adjoints[argumentIdentifier] += lhsAdjoint * jacobians[jacobianPosition + argument];
+        }
+      }
+
+      Adjoint result = 0.0;
+      for (size_t i = 0; i < nInputs; ++i) {
+        result += adjoints[identifiers[i]];
+        if (autoZero) {
+          adjoints[identifiers[i]] = 0.0;
+        }
+      }
+      return result;
+    }
+
+    /// Performs a forward evaluation, seeding all inputs with the given seed, and returns the sum of the tangents of
+    /// the outputs. Each left-hand side is assigned before it is read, so that tangents need not be zero beforehand.
+    /// Auto-zeroing resets the tangents of the inputs and all left-hand sides afterwards.
+    template<bool autoZero = true, typename Tangents, typename Tangent>
+    Tangent evaluateForward(Tangents& tangents, Tangent const& seed) {
+      auto const& identifiers = this->identifiers;
+      auto const& jacobians = this->jacobians;
+
+      for (size_t i = 0; i < nInputs; ++i) {
+        tangents[identifiers[i]] = seed;
+      }
+
+      size_t identifierPosition = nInputs;
+      size_t jacobianPosition = 0;
+      for (auto const& nArguments : argumentCounts) {
+        Identifier lhs = identifiers[identifierPosition++];
+        Tangent lhsTangent = 0.0;
+        for (size_t argument = 0; argument < nArguments; ++argument) {
+          lhsTangent += tangents[identifiers[identifierPosition++]] * jacobians[jacobianPosition++];
+        }
+        tangents[lhs] = lhsTangent;
+      }
+
+      Tangent result = 0.0;
+      for (size_t i = identifierPosition; i < identifiers.size(); ++i) {
+        result += tangents[identifiers[i]];
+      }
+
+      if (autoZero) {
+        for (size_t i = 0; i < nInputs; ++i) {
+          tangents[identifiers[i]] = 0.0;
+        }
+        identifierPosition = nInputs;
+        for (auto const& nArguments : argumentCounts) {
+          tangents[identifiers[identifierPosition]] = 0.0;
+          identifierPosition += nArguments + 1;
+        }
+      }
+      return result;
+    }
+
+    Span<Identifier const> getInputs() const {
+      return Span<Identifier const>(this->identifiers.data(), nInputs);
+    }
+
+    Span<Identifier const> getOutputs() const {
+      return Span<Identifier const>(this->identifiers.data() + this->identifiers.size() - nOutputs, nOutputs);
+    }
+
+    /// View the tape with a different, usually narrower, identifier type, like BasicTape::compact. The identifiers
+    /// are converted into the thread-local compacting scratch, Jacobians and argument counts are viewed in place.
+    template<typename CompactIdentifier>
+    BasicStatementTape<CompactIdentifier, Gradient, Span<CompactIdentifier const>, Span<Gradient const>,
+                       Span<uint8_t const>> compact() const {
+      auto& buffer = *CompactingScratch<CompactIdentifier>::identifiers;
+      buffer.assign(this->identifiers.begin(), this->identifiers.end());
+      return BasicStatementTape<CompactIdentifier, Gradient, Span<CompactIdentifier const>, Span<Gradient const>,
+                                Span<uint8_t const>>(
+          Span<CompactIdentifier const>(buffer.data(), buffer.size()),
+          Span<Gradient const>(this->jacobians.data(), this->jacobians.size()), this->remapped,
+          Span<uint8_t const>(argumentCounts.data(), argumentCounts.size()), nInputs, nOutputs);
+    }
+
+    /// Tape printing for debugging purposes.
+    void print() {
+      auto const& identifiers = this->identifiers;
+      std::cout << "  remapped: " << this->remapped << std::endl;
+      std::cout << "  inputs:";
+      for (size_t i = 0; i < nInputs; ++i) {
+        std::cout << " " << identifiers[i];
+      }
+      std::cout << std::endl;
+
+      size_t identifierPosition = nInputs;
+      size_t jacobianPosition = 0;
+      for (size_t statement = 0; statement < argumentCounts.size(); ++statement) {
+        std::cout << std::setw(10) << identifiers[identifierPosition++] << " <-";
+        for (size_t argument = 0; argument < argumentCounts[statement]; ++argument) {
+          std::cout << " " << identifiers[identifierPosition++] << " * " << this->jacobians[jacobianPosition++];
+        }
+        std::cout << std::endl;
+      }
+
+      std::cout << "  outputs:";
+      for (size_t i = identifiers.size() - nOutputs; i < identifiers.size(); ++i) {
+        std::cout << " " << identifiers[i];
+      }
+      std::cout << std::endl;
+    }
+};
+
+/// Statement tape that owns its identifiers, Jacobians and argument counts, and generates them.
+template<typename Identifier, typename Gradient>
+struct StatementTape : public BasicStatementTape<Identifier, Gradient, std::vector<Identifier>,
+                                                 std::vector<Gradient>, std::vector<uint8_t>> {
+  public:
+    using Base = BasicStatementTape<Identifier, Gradient, std::vector<Identifier>, std::vector<Gradient>,
+                                    std::vector<uint8_t>>;
+    using Base::argumentCounts;
+    using Base::nInputs;
+    using Base::nOutputs;
+
+    std::vector<Identifier> variables;  /// scratch for generation: inputs and left-hand sides in order of definition
+
+    StatementTape() : Base(), variables() {}
+
+    /// Generate a random DAG of the given number of statements in place, reusing the memory of this tape.
+    /// Inputs and left-hand sides are drawn by the given identifier model. Partials are in a neighborhood of
+    /// 1 / nArguments, so that adjoint values stay bounded. Deterministic with respect to the specified seed.
+    void generateInPlace(size_t nStatements, StatementShape const& shape, Identifier iMin, Identifier iMax,
+                         size_t randomSeed, Generators::Parameters const& model = Generators::Parameters(),
+                         uint64_t groupSeed = 0) {
+      std::mt19937 generator(randomSeed);
+      uint64_t range = static_cast<uint64_t>(iMax) - static_cast<uint64_t>(iMin) + 1;
+      nInputs = std::max<size_t>(std::min<uint64_t>(shape.nInputs, range), 1);
+      this->remapped = false;
+
+      std::uniform_int_distribution<size_t> argumentDistribution(1, std::max<size_t>(shape.maxArguments, 1));
+      argumentCounts.resize(nStatements);
+      size_t nArguments = 0;
+      for (auto& count : argumentCounts) {
+        count = static_cast<uint8_t>(std::min<size_t>(argumentDistribution(generator), 255));
+        nArguments += count;
+      }
+
+      variables.resize(nInputs + nStatements);
+      Generators::drawIdentifiers(variables.data(), variables.size(), iMin, iMax, model, groupSeed, generator);
+      for (size_t i = 1; i < nInputs; ++i) {  // inputs are distinct
+        while (std::find(variables.begin(), variables.begin() + i, variables[i]) != variables.begin() + i) {
+          variables[i] = iMin + static_cast<Identifier>((static_cast<uint64_t>(variables[i] - iMin) + 1) % range);
+        }
+      }
+
+      auto& identifiers = this->identifiers;
+      auto& jacobians = this->jacobians;
+      identifiers.resize(nInputs + nStatements + nArguments + shape.nOutputs);
+      jacobians.resize(nArguments);
+      std::copy(variables.begin(), variables.begin() + nInputs, identifiers.begin());
+
+      std::bernoulli_distribution recentDistribution(0.5);
+      size_t identifierPosition = nInputs;
+      size_t jacobianPosition = 0;
+      for (size_t statement = 0; statement < nStatements; ++statement) {
+        size_t nDefined = nInputs + statement;
+        size_t window = std::min(std::max<size_t>(shape.window, 1), nDefined);
+        std::uniform_int_distribution<size_t> recentVariable(nDefined - window, nDefined - 1);
+        std::uniform_int_distribution<size_t> anyVariable(0, nDefined - 1);
+
+        identifiers[identifierPosition++] = variables[nDefined];
+        for (size_t argument = 0; argument < argumentCounts[statement]; ++argument) {
+          bool recent = recentDistribution(generator);
+          Identifier identifier = variables[recent ? recentVariable(generator) : anyVariable(generator)];
+          identifiers[identifierPosition++] = identifier;
+          jacobians[jacobianPosition++] = (1.0 + 0.1 * std::sin(identifier)) / argumentCounts[statement];
+        }
+      }
+
+      // outputs are the distinct left-hand sides of the last statements, i.e., live at the end of the tape
+      nOutputs = 0;
+      size_t outputStart = identifierPosition;
+      for (size_t statement = nStatements; statement-- > 0 && nOutputs < shape.nOutputs;) {
+        identifierPosition -= argumentCounts[statement] + 1;
+        Identifier lhs = identifiers[identifierPosition];
+        if (std::find(identifiers.begin() + outputStart, identifiers.begin() + outputStart + nOutputs, lhs) ==
+            identifiers.begin() + outputStart + nOutputs) {
+          identifiers[outputStart + nOutputs++] = lhs;
+        }
+      }
+      identifiers.resize(outputStart + nOutputs);
+    }
+};
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -9,38 +10,169 @@
 #include <random>
 #include <vector>
 
+#include "flat_map.hpp"
+#include "generators.hpp"
+#include "span.hpp"
+
+/// Thread-local scratch memory for allocation-free identifier remapping, reused across tapes.
+template<typename Identifier>
+struct RemappingScratch {
+  public:
+    struct Pair {
+      Identifier identifier;
+      uint32_t position;
+    };
+
+    static std::vector<Pair>* pairs;                   /// (identifier, position) pairs to sort
+    static std::vector<Pair>* buffer;                  /// target of each radix sort pass
+    static FlatMap<Identifier, Identifier>* map;       /// old to new identifiers
+    #pragma omp threadprivate(pairs, buffer, map)
+
+    /// Release the scratch memory of the calling thread.
+    static void clear() {
+      *pairs = std::vector<Pair>();
+      *buffer = std::vector<Pair>();
+      *map = FlatMap<Identifier, Identifier>();
+    }
+};
+
+template<typename Identifier>
+std::vector<typename RemappingScratch<Identifier>::Pair>* RemappingScratch<Identifier>::pairs =
+    new std::vector<typename RemappingScratch<Identifier>::Pair>();
+
+template<typename Identifier>
+std::vector<typename RemappingScratch<Identifier>::Pair>* RemappingScratch<Identifier>::buffer =
+    new std::vector<typename RemappingScratch<Identifier>::Pair>();
+
+template<typename Identifier>
+FlatMap<Identifier, Identifier>* RemappingScratch<Identifier>::map = new FlatMap<Identifier, Identifier>();
+
+/// Thread-local buffer for the narrow identifiers of compacted tapes, reused across tapes.
+template<typename CompactIdentifier>
+struct CompactingScratch {
+  public:
+    static std::vector<CompactIdentifier>* identifiers;  /// identifiers of the last compacted tape
+    #pragma omp threadprivate(identifiers)
+
+    /// Release the scratch memory of the calling thread.
+    static void clear() {
+      *identifiers = std::vector<CompactIdentifier>();
+    }
+};
+
+template<typename CompactIdentifier>
+std::vector<CompactIdentifier>* CompactingScratch<CompactIdentifier>::identifiers =
+    new std::vector<CompactIdentifier>();
+
+template<typename Identifier, typename Gradient>
+struct Tape;
+
+/// Distance in tape entries at which evaluations prefetch the adjoint variables of upcoming identifiers, 0 disables
+/// prefetching. Applies to all strategies, each local adjoint container implements prefetch.
+inline size_t& getPrefetchDistance() {
+  static size_t distance = 0;
+  return distance;
+}
+
 /** @brief Simplified tape.
  *
  *  The implementation resembles a Jacobian tape of a computation with a single input, a single output, and only unary
  *  operations.
  *
  *  input -> o -> o -> o -> ... -> o -> o -> o -> output
+ *
+ *  Identifiers and Jacobians are stored in arrays of the given types, either owning (Tape) or not (TapeView).
  */
-template<typename Identifier, typename Gradient>
-struct Tape {
+template<typename Identifier, typename Gradient, typename IdentifierArray, typename JacobianArray>
+struct BasicTape {
   public:
-    std::vector<Identifier> identifiers;  /// virtual memory addresses to access
-    std::vector<Gradient> jacobians;      /// partials to multiply
-    bool remapped;                        /// indicator to avoid multiple remappings
+    IdentifierArray identifiers;  /// virtual memory addresses to access
+    JacobianArray jacobians;      /// partials to multiply
+    bool remapped;                /// indicator to avoid multiple remappings
 
-    Tape() : identifiers(), jacobians(), remapped(false) {}
+    BasicTape() : identifiers(), jacobians(), remapped(false) {}
+
+    BasicTape(IdentifierArray const& identifiers, JacobianArray const& jacobians, bool remapped)
+        : identifiers(identifiers), jacobians(jacobians), remapped(remapped) {}
 
     /// Performs the tape evaluation on the given adjoint variables with the given seed.
-    /// Reads and writes each adjoint memory location exactly once.
-    /// Auto-zeroes adjoint variables.
-    template<typename Adjoints>
-    Gradient evaluate(Adjoints& adjoints, Gradient seed) {
-      adjoints[identifiers[0]] = seed * jacobians[0];
-      for (size_t i = 1; i < identifiers.size(); ++i) {
+    /// Reads and writes each adjoint memory location exactly once, plus a zeroing write if auto-zeroing is enabled.
+    /// Auto-zeroing can be disabled for adjoint variables that are invalidated in bulk between evaluations.
+    /// The adjoint type is either Gradient or a pack of gradients that propagates multiple seeds at once.
+    /// With a prefetch distance d, entry i prefetches the adjoint variable of entry i + d.
+    template<bool autoZero = true, typename Adjoints, typename Adjoint>
+    Adjoint evaluate(Adjoints& adjoints, Adjoint const& seed) {
+      auto propagate = [&](size_t i) {
         auto identifier = identifiers[i];
         auto predecessor = identifiers[i - 1];
 
-        Gradient temp = adjoints[predecessor];  // account for the case identifier == predecessor
-        adjoints[predecessor] = 0.0;
+        Adjoint temp = adjoints[predecessor];  // account for the case identifier == predecessor
+        if (autoZero) {
+          adjoints[predecessor] = 0.0;
+        }
         adjoints[identifier] = temp * jacobians[i];
+      };
+
+      size_t size = identifiers.size();
+      size_t distance = getPrefetchDistance();
+      size_t prefetchEnd = distance != 0 && size > distance ? size - distance : 1;
+      if (distance != 0) {
+        for (size_t i = 1; i < std::min(distance + 1, size); ++i) {
+          adjoints.prefetch(identifiers[i]);
+        }
+      }
+
+      adjoints[identifiers[0]] = seed * jacobians[0];
+      for (size_t i = 1; i < prefetchEnd; ++i) {
+        adjoints.prefetch(identifiers[i + distance]);
+        propagate(i);
+      }
+      for (size_t i = prefetchEnd; i < size; ++i) {
+        propagate(i);
+      }
+      Adjoint result = adjoints[identifiers.back()];
+      if (autoZero) {
+        adjoints[identifiers.back()] = 0.0;
+      }
+      return result;
+    }
+
+    /// Performs a forward evaluation on the given tangent variables with the given seed, from the input at the end of
+    /// the identifiers to the output at the beginning. Mirrors evaluate, with the same memory accesses and result.
+    template<bool autoZero = true, typename Tangents, typename Tangent>
+    Tangent evaluateForward(Tangents& tangents, Tangent const& seed) {
+      auto propagate = [&](size_t i) {
+        auto identifier = identifiers[i];
+        auto successor = identifiers[i + 1];
+
+        Tangent temp = tangents[successor];  // account for the case identifier == successor
+        if (autoZero) {
+          tangents[successor] = 0.0;
+        }
+        tangents[identifier] = temp * jacobians[i];
+      };
+
+      size_t last = identifiers.size() - 1;
+      size_t distance = getPrefetchDistance();
+      size_t prefetchEnd = distance != 0 ? std::min(last, distance) : last;
+      if (distance != 0) {
+        for (size_t i = last; i-- > (last > distance ? last - distance : 0);) {
+          tangents.prefetch(identifiers[i]);
+        }
+      }
+
+      tangents[identifiers[last]] = seed * jacobians[last];
+      for (size_t i = last; i-- > prefetchEnd;) {
+        tangents.prefetch(identifiers[i - distance]);
+        propagate(i);
+      }
+      for (size_t i = prefetchEnd; i-- > 0;) {
+        propagate(i);
+      }
+      Tangent result = tangents[identifiers[0]];
+      if (autoZero) {
+        tangents[identifiers[0]] = 0.0;
       }
-      Gradient result = adjoints[identifiers.back()];
-      adjoints[identifiers.back()] = 0.0;
       return result;
     }
 
@@ -63,7 +195,86 @@ struct Tape {
       }
     }
 
-    Identifier getMaxIdentifier() {
+    /// Edit the tape and remap identifiers to a contiguous range, by sorting (identifier, position) pairs.
+    /// Least significant digit radix sort with 8-bit digits, in thread-local scratch memory.
+    /// New identifiers are assigned in increasing order of the old ones.
+    void remapIdentifiersRadixSort() {
+      if (!remapped) {
+        auto& pairs = *RemappingScratch<Identifier>::pairs;
+        auto& buffer = *RemappingScratch<Identifier>::buffer;
+
+        uint64_t minKey = static_cast<uint64_t>(getMinIdentifier());
+        uint64_t range = static_cast<uint64_t>(getMaxIdentifier()) - minKey;
+
+        pairs.resize(identifiers.size());
+        buffer.resize(identifiers.size());
+        for (size_t i = 0; i < identifiers.size(); ++i) {
+          pairs[i].identifier = identifiers[i];
+          pairs[i].position = static_cast<uint32_t>(i);
+        }
+
+        for (unsigned int shift = 0; shift < 64 && (range >> shift) != 0; shift += 8) {
+          size_t offsets[256] = {};
+          for (auto const& pair : pairs) {
+            ++offsets[((static_cast<uint64_t>(pair.identifier) - minKey) >> shift) & 0xFF];
+          }
+          size_t offset = 0;
+          for (auto& count : offsets) {
+            size_t digitCount = count;
+            count = offset;
+            offset += digitCount;
+          }
+          for (auto const& pair : pairs) {
+            buffer[offsets[((static_cast<uint64_t>(pair.identifier) - minKey) >> shift) & 0xFF]++] = pair;
+          }
+          pairs.swap(buffer);
+        }
+
+        Identifier nextIdentifier = 0;
+        for (size_t i = 0; i < pairs.size(); ++i) {
+          if (i == 0 || pairs[i].identifier != pairs[i - 1].identifier) {
+            nextIdentifier++;
+          }
+          identifiers[pairs[i].position] = nextIdentifier;
+        }
+
+        remapped = true;
+      }
+    }
+
+    /// Edit the tape and remap identifiers to a contiguous range, via a thread-local open-addressing map.
+    void remapIdentifiersFlatMap() {
+      if (!remapped) {
+        auto& identifierMap = *RemappingScratch<Identifier>::map;
+        Identifier nextIdentifier = 1;
+
+        for (auto& identifier : identifiers) {
+          Identifier& newIdentifier = identifierMap[identifier];
+          if (newIdentifier == 0) {  // value-initialized, i.e., inserted just now
+            newIdentifier = nextIdentifier++;
+          }
+          identifier = newIdentifier;
+        }
+
+        identifierMap.reset();
+        remapped = true;
+      }
+    }
+
+    /// View the tape with a different, usually narrower, identifier type. The identifiers are converted into the
+    /// thread-local compacting scratch, the Jacobians are viewed in place, so the view is valid until the next
+    /// compaction to the same type on this thread. Intended for remapped tapes whose identifiers fit into the compact
+    /// identifier type.
+    template<typename CompactIdentifier>
+    BasicTape<CompactIdentifier, Gradient, Span<CompactIdentifier const>, Span<Gradient const>> compact() const {
+      auto& buffer = *CompactingScratch<CompactIdentifier>::identifiers;
+      buffer.assign(identifiers.begin(), identifiers.end());
+      return BasicTape<CompactIdentifier, Gradient, Span<CompactIdentifier const>, Span<Gradient const>>(
+          Span<CompactIdentifier const>(buffer.data(), buffer.size()),
+          Span<Gradient const>(jacobians.data(), jacobians.size()), remapped);
+    }
+
+    Identifier getMaxIdentifier() const {
       Identifier currentMax = std::numeric_limits<Identifier>::min();
       for (auto const& identifier : identifiers) {
         currentMax = std::max(currentMax, identifier);
@@ -71,7 +282,7 @@ struct Tape {
       return currentMax;
     }
 
-    Identifier getMinIdentifier() {
+    Identifier getMinIdentifier() const {
       Identifier currentMin = std::numeric_limits<Identifier>::max();
       for (auto const& identifier : identifiers) {
         currentMin = std::min(currentMin, identifier);
@@ -79,34 +290,74 @@ struct Tape {
       return currentMin;
     }
 
+    /// Identifiers of the inputs of the preaccumulated Jacobian, whose adjoints are the result of an evaluation.
+    Span<Identifier const> getInputs() const {
+      return Span<Identifier const>(&identifiers[identifiers.size() - 1], 1);
+    }
+
+    /// Identifiers of the outputs of the preaccumulated Jacobian, which are seeded by an evaluation.
+    Span<Identifier const> getOutputs() const {
+      return Span<Identifier const>(&identifiers[0], 1);
+    }
+
+    /// Tape printing for debugging purposes.
+    void print() {
+      std::cout << "  remapped: " << remapped << std::endl;
+      for (size_t i = 0; i < identifiers.size(); ++i) {
+        std::cout << std::setw(10) << identifiers[i] << " " << jacobians[i] << std::endl;
+      }
+    }
+};
+
+/// Tape that owns its identifiers and Jacobians.
+template<typename Identifier, typename Gradient>
+struct Tape : public BasicTape<Identifier, Gradient, std::vector<Identifier>, std::vector<Gradient>> {
+  public:
     /// Generate a tape of a given size, drawing random identifiers uniformly from the specified range.
     /// Produces Jacobians in a neighborhood of 1.0.
     /// Deterministic with respect to the specified seed.
     static std::shared_ptr<Tape> generate(size_t size, Identifier iMin, Identifier iMax, size_t randomSeed) {
       std::shared_ptr<Tape> result(new Tape);
 
-      std::mt19937 generator(randomSeed);
-      std::uniform_int_distribution<Identifier> distribution(iMin, iMax);
-
       result->identifiers.resize(size);
       result->jacobians.resize(size);
-
-      for (size_t i = 0; i < size; ++i) {
-        result->identifiers[i] = distribution(generator);
-        result->jacobians[i] = 1.0 + 0.1 * std::sin(result->identifiers[i]);
-      }
+      generate(result->identifiers.data(), result->jacobians.data(), size, iMin, iMax, randomSeed);
 
       return result;
     }
 
-    /// Tape printing for debugging purposes.
-    void print() {
-      std::cout << "  remapped: " << remapped << std::endl;
-      for (size_t i = 0; i < identifiers.size(); ++i) {
-        std::cout << std::setw(10) << identifiers[i] << " " << jacobians[i] << std::endl;
+    /// Generate a tape as above in place, reusing the memory of this tape, with identifiers drawn by the given model.
+    void generateInPlace(size_t size, Identifier iMin, Identifier iMax, size_t randomSeed,
+                         Generators::Parameters const& model = Generators::Parameters(), uint64_t groupSeed = 0) {
+      this->identifiers.resize(size);
+      this->jacobians.resize(size);
+      this->remapped = false;
+      generate(this->identifiers.data(), this->jacobians.data(), size, iMin, iMax, randomSeed, model, groupSeed);
+    }
+
+    /// Generate a tape as above into the given memory, with identifiers drawn by the given model.
+    static void generate(Identifier* identifiers, Gradient* jacobians, size_t size, Identifier iMin, Identifier iMax,
+                         size_t randomSeed, Generators::Parameters const& model = Generators::Parameters(),
+                         uint64_t groupSeed = 0) {
+      std::mt19937 generator(randomSeed);
+      Generators::drawIdentifiers(identifiers, size, iMin, iMax, model, groupSeed, generator);
+
+      for (size_t i = 0; i < size; ++i) {
+        jacobians[i] = 1.0 + 0.1 * std::sin(identifiers[i]);
       }
     }
 };
 
+/// Tape that evaluates identifiers and Jacobians in place, e.g., as part of a larger workload.
+/// Remapping edits the viewed identifiers.
+template<typename Identifier, typename Gradient>
+struct TapeView : public BasicTape<Identifier, Gradient, Span<Identifier>, Span<Gradient>> {
+  public:
+    using Base = BasicTape<Identifier, Gradient, Span<Identifier>, Span<Gradient>>;
+
+    TapeView(Identifier* identifiers, Gradient* jacobians, size_t size, bool remapped)
+        : Base(Span<Identifier>(identifiers, size), Span<Gradient>(jacobians, size), remapped) {}
+};
+
 
 
@@ -1,16 +1,40 @@
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
+#include <numeric>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
+#include "allocation.hpp"
 #include "benchmark.hpp"
 #include "evaluation_strategies.hpp"
+#include "flat_map.hpp"
 #include "local_adjoints.hpp"
 #include "preaccumulations.hpp"
+#include "statement_tape.hpp"
 #include "tape.hpp"
 
 template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
 void testEvaluation(std::string const& name, Tape<Identifier, Gradient>& tape, Gradient const& seed) {
   std::cout << std::setw(60) << name << std::setw(10)
-            << EvaluationStrategy::evaluate<Identifier, Gradient, strategy>(tape, {seed}) << std::endl;
+            << EvaluationStrategy::evaluate<Identifier, Gradient, strategy>(tape, std::vector<Gradient>{seed})
+            << std::endl;
+}
+
+/// Evaluates a copy of the given statement tape, so that editing strategies do not affect subsequent tests.
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy,
+         typename Sweeps = EvaluationStrategy::ScalarSweeps<Gradient>>
+void testStatements(std::string const& name, StatementTape<Identifier, Gradient> tape,
+                    std::vector<Gradient> const& seeds) {
+  std::cout << std::setw(60) << name << std::setw(10)
+            << EvaluationStrategy::evaluate<Identifier, Gradient, strategy, Sweeps>(tape, seeds) << std::endl;
+}
+
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy, typename Sweeps>
+void testSweeps(std::string const& name, Tape<Identifier, Gradient>& tape, std::vector<Gradient> const& seeds) {
+  std::cout << std::setw(60) << name << std::setw(10)
+            << EvaluationStrategy::evaluate<Identifier, Gradient, strategy, Sweeps>(tape, seeds) << std::endl;
 }
 
 template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
@@ -18,6 +42,76 @@ void testPreacc(std::string const& name, Preaccumulations<Identifier, Gradient>&
   std::cout << std::setw(60) << name << std::setw(10) << preaccs.template run<strategy>(1.0) << std::endl;
 }
 
+/// Prints the result, and the number of records and the checksum of the global tape.
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
+void testGlobalTape(std::string const& name, Preaccumulations<Identifier, Gradient>& preaccs, Gradient const& seed) {
+  Gradient result = preaccs.template run<strategy>(seed);
+  std::cout << std::setw(60) << name << std::setw(10) << result << std::setw(10)
+            << preaccs.globalTape.getNumberOfRecords() << std::setw(10) << preaccs.globalTape.getChecksum()
+            << std::endl;
+}
+
+/// Pushes records into a global tape of 64 byte chunks until it throws as it is full, and prints the number of
+/// stored records.
+template<typename Identifier, typename Gradient>
+void testGlobalTapeCapacity(std::string const& name, GlobalTape::Scheme scheme) {
+  GlobalTape::Buffer<Identifier, Gradient> globalTape;
+  globalTape.scheme = scheme;
+  globalTape.chunkSize = 64;
+  globalTape.clear(1, GlobalTape::getRecordSize<Identifier, Gradient>(1, 1));
+  Identifier identifier = 1;
+  Gradient jacobian = 1.0;
+  try {
+    while (true) {
+      globalTape.push(Span<Identifier const>(&identifier, 1), Span<Identifier const>(&identifier, 1),
+                      Span<Gradient const>(&jacobian, 1));
+    }
+  } catch (std::length_error const&) {
+  }
+  std::cout << std::setw(60) << name << std::setw(10) << globalTape.getNumberOfRecords() << std::endl;
+}
+
+/// Prints the result, the number of work items in forward mode and the fraction of swept tape entries saved.
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
+void testMode(std::string const& name, Preaccumulations<Identifier, Gradient>& preaccs, Gradient const& seed) {
+  Gradient result = preaccs.template run<strategy>(seed);
+  std::cout << std::setw(60) << name << std::setw(10) << result << std::setw(10) << preaccs.nForwardItems
+            << std::setw(10) << preaccs.sweepSavings << std::endl;
+}
+
+/// Prints the result and the number of work items split into tasks.
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
+void testSplit(std::string const& name, Preaccumulations<Identifier, Gradient>& preaccs, Gradient const& seed) {
+  Gradient result = preaccs.template run<strategy>(seed);
+  std::cout << std::setw(60) << name << std::setw(10) << result << std::setw(10) << preaccs.nSplitItems << std::endl;
+}
+
+/// Prints the result, the number of work items split into tasks and the number of tapes counted by the adaptive
+/// strategy, which chooses its path once per tape.
+template<typename Identifier, typename Gradient>
+void testAdaptiveSplit(std::string const& name, Preaccumulations<Identifier, Gradient>& preaccs,
+                       Gradient const& seed) {
+  Adaptive::reset();
+  Gradient result = preaccs.template run<EvaluationStrategy::ADAPTIVE>(seed);
+  Adaptive::PathCounts const& counts = Adaptive::getCollectedCounts();
+  size_t nTapes = std::accumulate(counts.counts, counts.counts + Adaptive::NUMBER_OF_PATHS, size_t(0));
+  std::cout << std::setw(60) << name << std::setw(10) << result << std::setw(10) << preaccs.nSplitItems
+            << std::setw(10) << nTapes << std::endl;
+  Adaptive::reset();
+}
+
+/// Prints the result and the largest total of the peak bytes of local adjoints over all threads.
+template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
+void testMemory(std::string const& name, Preaccumulations<Identifier, Gradient>& preaccs, Gradient const& seed) {
+  Memory::resetAdjointPeaks();
+  Gradient result = preaccs.template run<strategy>(seed);
+  size_t peak = 0;
+  for (auto const& threadPeaks : Memory::collectAdjointPeaks()) {
+    peak = std::max(peak, threadPeaks.getTotal());
+  }
+  std::cout << std::setw(60) << name << std::setw(10) << result << std::setw(10) << peak << std::endl;
+}
+
 template<typename Identifier, typename Gradient, EvaluationStrategy::Strategy strategy>
 void testBenchmark(std::string const& name, Benchmark<Identifier, Gradient> benchmark,
                    Preaccumulations<Identifier, Gradient>& preaccs) {
@@ -69,6 +163,105 @@ int main(int argc, char** argv) {
   localTapeCopy = *tape;
   testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
       "editing with std::unordered_map, temporary vector", localTapeCopy, seed);
+  testEvaluation<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", *tape, seed);
+  testEvaluation<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                          *tape, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", localTapeCopy, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", localTapeCopy, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                     localTapeCopy, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>(
+      "editing with open addressing map, temporary vector", localTapeCopy, seed);
+  testEvaluation<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>(
+      "persistent vector in reserved virtual memory", *tape, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", localTapeCopy, seed);
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", *tape, seed);
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", *tape, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", localTapeCopy, seed);
+
+  localTapeCopy = *tape;
+  testEvaluation<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", localTapeCopy, seed);
+  testEvaluation<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", *tape, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Evaluations in vector mode with vector width 4 and seeds 1, 2, 3, 4, 5." << std::endl;
+  std::cout << "Evaluation should yield " << 15.0 * J << "." << std::endl;
+
+  using Sweeps = EvaluationStrategy::VectorSweeps<Gradient, 4>;
+  std::vector<Gradient> const seeds = {1.0, 2.0, 3.0, 4.0, 5.0};
+
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP, Sweeps>("temporary map, std::map", *tape, seeds);
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP, Sweeps>("temporary map, std::unordered_map",
+                                                                              *tape, seeds);
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_VECTOR, Sweeps>("temporary vector", *tape, seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_VECTOR, Sweeps>("persistent vector", *tape, seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET, Sweeps>("persistent vector with offset", *tape,
+                                                                               seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING, Sweeps>("editing with std::map, temporary vector",
+                                                                            localTapeCopy, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING, Sweeps>(
+      "editing with std::unordered_map, temporary vector", localTapeCopy, seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP, Sweeps>("persistent map, open addressing", *tape,
+                                                                          seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR, Sweeps>(
+      "persistent vector with epochs, no zeroing", *tape, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT, Sweeps>(
+      "editing with std::map, compact tape, temporary vector", localTapeCopy, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT, Sweeps>(
+      "editing with std::unordered_map, compact tape, temporary vector", localTapeCopy, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::RADIX_SORT_EDITING, Sweeps>("editing with radix sort, temporary vector",
+                                                                         localTapeCopy, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::FLAT_MAP_EDITING, Sweeps>(
+      "editing with open addressing map, temporary vector", localTapeCopy, seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR, Sweeps>(
+      "persistent vector in reserved virtual memory", *tape, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::ADAPTIVE, Sweeps>("adaptive", localTapeCopy, seeds);
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA, Sweeps>(
+      "temporary map, std::map, arena allocator", *tape, seeds);
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA, Sweeps>(
+      "temporary map, std::unordered_map, arena allocator", *tape, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA, Sweeps>(
+      "editing with std::map, arena allocator, temporary vector", localTapeCopy, seeds);
+
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA, Sweeps>(
+      "editing with std::unordered_map, arena allocator, temporary vector", localTapeCopy, seeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR, Sweeps>("persistent paged vector", *tape, seeds);
 
   std::cout << std::endl;
 
@@ -77,6 +270,123 @@ int main(int argc, char** argv) {
   tape->print();
   std::cout << std::endl;
 
+  std::cout << "Example statement tape." << std::endl;
+  StatementShape shape;
+  StatementTape<Identifier, Gradient> statementTape;
+  statementTape.generateInPlace(size, shape, iMin, iMax, randomSeed);
+  statementTape.print();
+
+  // reference by forward propagation, seeding all inputs with 1 and summing the tangents of all outputs
+  std::map<Identifier, Gradient> tangents;
+  for (size_t i = 0; i < statementTape.nInputs; ++i) {
+    tangents[statementTape.identifiers[i]] = 1.0;
+  }
+  size_t identifierPosition = statementTape.nInputs;
+  size_t jacobianPosition = 0;
+  for (auto const& nArguments : statementTape.argumentCounts) {
+    Identifier lhs = statementTape.identifiers[identifierPosition++];
+    Gradient tangent = 0.0;
+    for (size_t argument = 0; argument < nArguments; ++argument) {
+      tangent += statementTape.jacobians[jacobianPosition++] * tangents[statementTape.identifiers[identifierPosition++]];
+    }
+    tangents[lhs] = tangent;
+  }
+  Gradient statementJ = 0.0;
+  for (size_t i = identifierPosition; i < statementTape.identifiers.size(); ++i) {
+    statementJ += tangents[statementTape.identifiers[i]];
+  }
+  std::cout << "Evaluation should yield " << statementJ << "." << std::endl;
+  std::cout << std::endl;
+
+  std::cout << "Evaluations of the statement tape with all adjoint variants." << std::endl;
+
+  std::vector<Gradient> const statementSeeds = {seed};
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", statementTape,
+                                                                    statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>("persistent vector with offset",
+                                                                           statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map", statementTape,
+                                                                statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map",
+                                                                          statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING>("editing with std::map, temporary vector",
+                                                                        statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
+      "editing with std::unordered_map, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing",
+                                                                      statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>(
+      "persistent vector with epochs, no zeroing", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                     statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>(
+      "editing with open addressing map, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>(
+      "persistent vector in reserved virtual memory", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>(
+      "persistent paged vector", statementTape, statementSeeds);
+
+  std::cout << std::endl;
+
+  std::cout << "Evaluations of the statement tape in vector mode with vector width 4 and seeds 1, 2, 3, 4, 5."
+            << std::endl;
+  std::cout << "Evaluation should yield " << 15.0 * statementJ << "." << std::endl;
+
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_MAP, Sweeps>("temporary map, std::map", statementTape,
+                                                                        seeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_VECTOR, Sweeps>("persistent vector", statementTape,
+                                                                            seeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR, Sweeps>(
+      "persistent vector with epochs, no zeroing", statementTape, seeds);
+  testStatements<Identifier, Gradient, Strategy::RADIX_SORT_EDITING, Sweeps>(
+      "editing with radix sort, temporary vector", statementTape, seeds);
+  testStatements<Identifier, Gradient, Strategy::ADAPTIVE, Sweeps>("adaptive", statementTape, seeds);
+
+  std::cout << std::endl;
+
+  std::cout << "Evaluations in forward mode of the example tape and the statement tape." << std::endl;
+  std::cout << "Evaluations should yield " << J << ", " << statementJ << " and in vector mode " << 15.0 * statementJ
+            << "." << std::endl;
+
+  using ForwardSweeps = EvaluationStrategy::ScalarSweeps<Gradient, EvaluationStrategy::FORWARD>;
+
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_VECTOR, ForwardSweeps>("temporary vector", *tape,
+                                                                              statementSeeds);
+  testSweeps<Identifier, Gradient, Strategy::TEMPORARY_MAP, ForwardSweeps>("temporary map, std::map", *tape,
+                                                                           statementSeeds);
+  testSweeps<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR, ForwardSweeps>(
+      "persistent vector with epochs, no zeroing", *tape, statementSeeds);
+  localTapeCopy = *tape;
+  testSweeps<Identifier, Gradient, Strategy::RADIX_SORT_EDITING, ForwardSweeps>(
+      "editing with radix sort, temporary vector", localTapeCopy, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::TEMPORARY_VECTOR, ForwardSweeps>(
+      "statement tape, temporary vector", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP, ForwardSweeps>(
+      "statement tape, persistent map, open addressing", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR, ForwardSweeps>(
+      "statement tape, persistent vector with epochs, no zeroing", statementTape, statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::ADAPTIVE, ForwardSweeps>("statement tape, adaptive", statementTape,
+                                                                          statementSeeds);
+  testStatements<Identifier, Gradient, Strategy::ADAPTIVE,
+                 EvaluationStrategy::VectorSweeps<Gradient, 4, EvaluationStrategy::FORWARD>>(
+      "statement tape, adaptive, vector mode, seeds 1 to 5", statementTape, seeds);
+
+  std::cout << std::endl;
+
   std::cout << "Simultaneous preaccumulations." << std::endl;
 
   size_t const nPreaccs = 10000;
@@ -100,6 +410,411 @@ int main(int argc, char** argv) {
                                                                     preaccs, seed);
   testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
       "editing with std::unordered_map, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector", preaccs,
+                                                                 seed);
+  testPreacc<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>("editing with open addressing map, temporary vector",
+                                                               preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>("persistent vector in reserved virtual memory",
+                                                                         preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", preaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations in vector mode with vector width 4." << std::endl;
+
+  preaccs.vectorWidth = 4;
+
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map", preaccs,
+                                                                          seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>("persistent vector with offset", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING>("editing with std::map, temporary vector",
+                                                                    preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
+      "editing with std::unordered_map, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector", preaccs,
+                                                                 seed);
+  testPreacc<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>("editing with open addressing map, temporary vector",
+                                                               preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>("persistent vector in reserved virtual memory",
+                                                                         preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", preaccs, seed);
+
+  preaccs.vectorWidth = 1;
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with pregenerated workload." << std::endl;
+
+  Preaccumulations<Identifier, Gradient> pregeneratedPreaccs = preaccs;
+  pregeneratedPreaccs.pregenerate();
+
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map",
+                                                                      pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>("persistent vector with offset",
+                                                                       pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING>("editing with std::map, temporary vector",
+                                                                    pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
+      "editing with std::unordered_map, temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing",
+                                                                  pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                 pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>("editing with open addressing map, temporary vector",
+                                                               pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>("persistent vector in reserved virtual memory",
+                                                                         pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>(
+      "persistent paged vector", pregeneratedPreaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with pregenerated workload, keeping remapped tapes." << std::endl;
+
+  pregeneratedPreaccs.keepRemapped = true;
+
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                 pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector (again)",
+                                                                 pregeneratedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", pregeneratedPreaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations replayed from a recorded trace." << std::endl;
+
+  std::string const tracePath = "tests_trace.bin";
+  preaccs.record(tracePath);
+  Preaccumulations<Identifier, Gradient> replayedPreaccs = preaccs;
+  replayedPreaccs.replay(tracePath, false);
+
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", replayedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", replayedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                 replayedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", replayedPreaccs, seed);
+  replayedPreaccs.keepRemapped = true;
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>(
+      "editing with radix sort, keeping remapped tapes", replayedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, remapped tapes", replayedPreaccs,
+                                                                seed);
+  replayedPreaccs.replay(tracePath, true);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>(
+      "editing with radix sort, streaming", replayedPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, streaming", replayedPreaccs, seed);
+  std::remove(tracePath.c_str());
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with different identifier models." << std::endl;
+
+  Preaccumulations<Identifier, Gradient> modelPreaccs = preaccs;
+  modelPreaccs.identifierModel.zipfExponent = 0.5;
+  char const* const modelNames[] = {"clustered", "zipf", "shared"};
+  Generators::Model const models[] = {Generators::CLUSTERED, Generators::ZIPF, Generators::SHARED};
+  for (size_t model = 0; model < 3; ++model) {
+    modelPreaccs.identifierModel.model = models[model];
+    std::string name = modelNames[model];
+    testPreacc<Identifier, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map, " + name, modelPreaccs, seed);
+    testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, " + name, modelPreaccs, seed);
+    testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, " + name, modelPreaccs,
+                                                                   seed);
+  }
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with unsigned and 64-bit identifiers and float gradients." << std::endl;
+
+  Preaccumulations<uint32_t, Gradient> uint32Preaccs(nPreaccs, preaccSizeMin, preaccSizeMax, nEvalMin, nEvalMax, iMin,
+                                                     iMax, randomSeed);
+  testPreacc<uint32_t, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, uint32", uint32Preaccs, seed);
+  testPreacc<uint32_t, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing, uint32",
+                                                                uint32Preaccs, seed);
+  testPreacc<uint32_t, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, uint32", uint32Preaccs, seed);
+
+  // identifiers beyond 32 bits, all strategies should yield the same result
+  int64_t const largeOffset = int64_t(1) << 40;
+  Preaccumulations<int64_t, Gradient> int64Preaccs(nPreaccs, preaccSizeMin, preaccSizeMax, nEvalMin, nEvalMax,
+                                                   largeOffset + iMin, largeOffset + iMax, randomSeed);
+  testPreacc<int64_t, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map, int64", int64Preaccs, seed);
+  testPreacc<int64_t, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>("persistent vector with offset, int64",
+                                                                    int64Preaccs, seed);
+  testPreacc<int64_t, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, int64", int64Preaccs, seed);
+  testPreacc<int64_t, Gradient, Strategy::ADAPTIVE>("adaptive, int64", int64Preaccs, seed);
+
+  Preaccumulations<uint64_t, float> uint64Preaccs(nPreaccs, preaccSizeMin, preaccSizeMax, nEvalMin, nEvalMax,
+                                                  largeOffset + iMin, largeOffset + iMax, randomSeed);
+  testPreacc<uint64_t, float, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map, uint64, float",
+                                                                 uint64Preaccs, 1.0f);
+  testPreacc<uint64_t, float, Strategy::FLAT_MAP_EDITING>("editing with open addressing map, uint64, float",
+                                                          uint64Preaccs, 1.0f);
+  testPreacc<uint64_t, float, Strategy::RADIX_SORT_EDITING>("editing with radix sort, uint64, float", uint64Preaccs,
+                                                            1.0f);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with statement tapes." << std::endl;
+
+  Preaccumulations<Identifier, Gradient> statementPreaccs = preaccs;
+  statementPreaccs.statementTapes = true;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", statementPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", statementPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map",
+                                                                      statementPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", statementPreaccs,
+                                                                  seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      statementPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                 statementPreaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", statementPreaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with a global tape, with result, records and checksum." << std::endl;
+
+  Preaccumulations<Identifier, Gradient> globalTapePreaccs = preaccs;
+  globalTapePreaccs.globalTape.scheme = GlobalTape::LOCK;
+  testGlobalTape<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, lock", globalTapePreaccs, seed);
+  globalTapePreaccs.globalTape.scheme = GlobalTape::ATOMIC;
+  testGlobalTape<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, atomic", globalTapePreaccs,
+                                                                   seed);
+  globalTapePreaccs.globalTape.scheme = GlobalTape::SEGMENTS;
+  testGlobalTape<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, segments", globalTapePreaccs,
+                                                                   seed);
+  testGlobalTape<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, segments",
+                                                                     globalTapePreaccs, seed);
+  globalTapePreaccs.globalTape = GlobalTape::Buffer<Identifier, Gradient>();
+  globalTapePreaccs.globalTape.scheme = GlobalTape::ATOMIC;
+  globalTapePreaccs.globalTape.chunkSize = 64;
+  testGlobalTape<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, atomic, 64 byte chunks",
+                                                                    globalTapePreaccs, seed);
+  globalTapePreaccs.globalTape.scheme = GlobalTape::LOCK;
+  testGlobalTape<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, lock, 64 byte chunks",
+                                                                    globalTapePreaccs, seed);
+  statementPreaccs.globalTape.scheme = GlobalTape::ATOMIC;
+  testGlobalTape<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, statement tapes, atomic",
+                                                                   statementPreaccs, seed);
+  statementPreaccs.globalTape.scheme = GlobalTape::SEGMENTS;
+  testGlobalTape<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, statement tapes, segments",
+                                                                   statementPreaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Global tapes of 64 byte chunks filled until they are full, should have "
+            << GlobalTape::Buffer<Identifier, Gradient>::maxChunks * 2 << " records." << std::endl;
+
+  testGlobalTapeCapacity<Identifier, Gradient>("lock", GlobalTape::LOCK);
+  testGlobalTapeCapacity<Identifier, Gradient>("atomic", GlobalTape::ATOMIC);
+
+  std::cout << std::endl;
+
+  std::cout << "Open addressing map, the reserved empty key should throw and not be inserted." << std::endl;
+
+  FlatMap<Identifier, Gradient> flatMap;
+  bool thrown = false;
+  try {
+    flatMap[FlatMap<Identifier, Gradient>::emptyKey()] = 1.0;
+  } catch (std::invalid_argument const&) {
+    thrown = true;
+  }
+  std::cout << std::setw(60) << "reserved key, thrown and size" << std::setw(10) << thrown << std::setw(10)
+            << flatMap.size() << std::endl;
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations in forward and automatic mode, with work items in forward mode and"
+            << " savings." << std::endl;
+
+  Preaccumulations<Identifier, Gradient> modePreaccs = preaccs;
+  modePreaccs.mode = EvaluationStrategy::FORWARD;
+  modePreaccs.nInputsMin = 1;
+  modePreaccs.nInputsMax = 1;
+  testMode<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, forward, one input", modePreaccs, seed);
+  modePreaccs.mode = EvaluationStrategy::AUTOMATIC;
+  modePreaccs.nInputsMin = nEvalMin;
+  modePreaccs.nInputsMax = nEvalMax;
+  testMode<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, automatic", modePreaccs, seed);
+  testMode<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing, automatic",
+                                                                modePreaccs, seed);
+  testMode<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, automatic", modePreaccs,
+                                                               seed);
+  modePreaccs.vectorWidth = 4;
+  testMode<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, automatic, vector mode",
+                                                              modePreaccs, seed);
+  statementPreaccs.mode = EvaluationStrategy::AUTOMATIC;
+  statementPreaccs.globalTape.scheme = GlobalTape::NONE;
+  testMode<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, statement tapes, automatic",
+                                                             statementPreaccs, seed);
+
+  std::cout << std::endl;
+
+  // persistent vectors grow geometrically across work items and count their capacity
+  std::cout << "Simultaneous preaccumulations with peak bytes of local adjoints, temporary vectors should have "
+            << (iMax + 1) * sizeof(Gradient) << " bytes, persistent vectors at least that, the epoch vector at least "
+            << (iMax + 1) * sizeof(LocalAdjoints::PersistentEpochVector<Identifier, Gradient>::Slot)
+            << " bytes." << std::endl;
+
+  testMemory<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::TEMPORARY_MAP>("temporary map, std::map", preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map", preaccs,
+                                                                      seed);
+  testMemory<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>(
+      "persistent vector in reserved virtual memory", preaccs, seed);
+  testMemory<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", preaccs, seed);
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with work items split into tasks above cost 300, with split work items."
+            << std::endl;
+
+  Preaccumulations<Identifier, Gradient> splitPreaccs = preaccs;
+  splitPreaccs.splitThreshold = 300.0;
+  testSplit<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", splitPreaccs, seed);
+  testSplit<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", splitPreaccs, seed);
+  testSplit<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", splitPreaccs,
+                                                                 seed);
+  testSplit<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                splitPreaccs, seed);
+  testSplit<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", splitPreaccs, seed);
+  // map for single sweeps, editing otherwise, so that the path of a work item differs from that of its groups
+  Adaptive::CostModel costModel = Adaptive::getCostModel();
+  Adaptive::getCostModel().spanCost = 0.0;
+  Adaptive::getCostModel().missCost = 1e9;
+  Adaptive::getCostModel().cacheSpan = 0.0;
+  Adaptive::getCostModel().mapCost = 3.0;
+  Adaptive::getCostModel().remapCost = 2.0;
+  testAdaptiveSplit("adaptive, path depends on the number of sweeps, tapes", splitPreaccs, seed);
+  Adaptive::getCostModel() = costModel;
+  splitPreaccs.mode = EvaluationStrategy::AUTOMATIC;
+  testSplit<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, automatic", splitPreaccs, seed);
+  splitPreaccs.mode = EvaluationStrategy::REVERSE;
+  splitPreaccs.vectorWidth = 4;
+  testSplit<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, vector mode", splitPreaccs, seed);
+  statementPreaccs.mode = EvaluationStrategy::REVERSE;
+  statementPreaccs.splitThreshold = 300.0;
+  testSplit<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, statement tapes", statementPreaccs,
+                                                              seed);
+  statementPreaccs.splitThreshold = 0.0;
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with prefetch distance 8, all strategies should yield the same result."
+            << std::endl;
+
+  getPrefetchDistance() = 8;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>("persistent vector with offset", preaccs,
+                                                                       seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP>("temporary map, std::unordered_map", preaccs,
+                                                                      seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                      preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector", preaccs,
+                                                                 seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>("persistent vector in reserved virtual memory",
+                                                                         preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", preaccs, seed);
+  testMode<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, automatic, vector mode",
+                                                              modePreaccs, seed);
+  getPrefetchDistance() = 1000;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, distance beyond the tape size",
+                                                               preaccs, seed);
+  getPrefetchDistance() = 0;
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with different schedules." << std::endl;
+
+  preaccs.schedule = Scheduling::DYNAMIC;
+  preaccs.chunkSize = 16;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, dynamic schedule", preaccs, seed);
+  preaccs.schedule = Scheduling::GUIDED;
+  preaccs.chunkSize = 0;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, guided schedule", preaccs, seed);
+  preaccs.schedule = Scheduling::COST_MODEL;
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, cost model schedule", preaccs, seed);
+  testPreacc<Identifier, Gradient, Strategy::TEMPORARY_VECTOR>("temporary vector, cost model schedule (again)", preaccs,
+                                                               seed);
+  pregeneratedPreaccs.schedule = Scheduling::COST_MODEL;
+  testPreacc<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>(
+      "editing with radix sort, temporary vector, cost model schedule", pregeneratedPreaccs, seed);
+  preaccs.schedule = Scheduling::STATIC;
+
+  std::cout << std::endl;
+
+  std::cout << "Simultaneous preaccumulations with different allocators for persistent vectors." << std::endl;
+
+  Allocation::getKind() = Allocation::FIRST_TOUCH;
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR>("persistent vector, first touch", preaccs, seed);
+  Allocation::getKind() = Allocation::TRANSPARENT_HUGE_PAGES;
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_VECTOR_OFFSET>(
+      "persistent vector with offset, transparent huge pages", preaccs, seed);
+  Allocation::getKind() = Allocation::HUGE_PAGES;
+  testPreacc<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>(
+      "persistent vector with epochs, no zeroing, huge pages", preaccs, seed);
+  Allocation::getKind() = Allocation::DEFAULT;
 
   std::cout << std::endl;
 
@@ -122,6 +837,65 @@ int main(int argc, char** argv) {
                                                                        benchmark, preaccs);
   testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING>(
       "editing with std::unordered_map, temporary vector", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::PERSISTENT_FLAT_MAP>("persistent map, open addressing", benchmark,
+                                                                     preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::PERSISTENT_EPOCH_VECTOR>("persistent vector with epochs, no zeroing",
+                                                                         benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_COMPACT>(
+      "editing with std::map, compact tape, temporary vector", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_COMPACT>(
+      "editing with std::unordered_map, compact tape, temporary vector", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::RADIX_SORT_EDITING>("editing with radix sort, temporary vector",
+                                                                    benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::FLAT_MAP_EDITING>("editing with open addressing map, temporary vector",
+                                                                  benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::PERSISTENT_RESERVED_VECTOR>(
+      "persistent vector in reserved virtual memory", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::ADAPTIVE>("adaptive", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_MAP_ARENA>(
+      "temporary map, std::map, arena allocator", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_ARENA>(
+      "temporary map, std::unordered_map, arena allocator", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_MAP_EDITING_ARENA>(
+      "editing with std::map, arena allocator, temporary vector", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::TEMPORARY_UNORDERED_MAP_EDITING_ARENA>(
+      "editing with std::unordered_map, arena allocator, temporary vector", benchmark, preaccs);
+  testBenchmark<Identifier, Gradient, Strategy::PERSISTENT_PAGED_VECTOR>("persistent paged vector", benchmark, preaccs);
+
+  std::cout << std::endl;
+
+  std::cout << "Paths chosen by the adaptive strategy." << std::endl;
+  auto adaptiveData = benchmark.run<Strategy::ADAPTIVE>(preaccs);
+  Adaptive::print(std::cout, adaptiveData.pathCounts, nRuns);
+
+  std::cout << std::endl;
+
+  std::cout << "Allocations of the persistent vector strategy, independent of the number of work items." << std::endl;
+  auto allocationData = benchmark.run<Strategy::PERSISTENT_VECTOR>(preaccs);
+  AllocationCounter::print(std::cout, allocationData.allocations, nRuns);
+
+  std::cout << std::endl;
+
+  std::cout << "Runtime statistics of the benchmark." << std::endl;
+  auto statisticsData = benchmark.run<Strategy::PERSISTENT_VECTOR>(preaccs);
+  std::cout << std::setw(60) << "number of runtimes" << std::setw(10) << statisticsData.runtimes.size() << std::endl;
+  std::cout << std::setw(60) << "minimum <= p05 <= median <= p95 <= maximum" << std::setw(10)
+            << (statisticsData.runtimeMin <= statisticsData.runtimeP05 &&
+                statisticsData.runtimeP05 <= statisticsData.runtimeMedian &&
+                statisticsData.runtimeMedian <= statisticsData.runtimeP95 &&
+                statisticsData.runtimeP95 <= statisticsData.runtimeMax) << std::endl;
+  std::cout << std::setw(60) << "confidence interval contains average" << std::setw(10)
+            << (statisticsData.runtimeCiLow <= statisticsData.runtimeAvg &&
+                statisticsData.runtimeAvg <= statisticsData.runtimeCiHigh) << std::endl;
+  std::vector<double> values = {1.0, 2.0, 3.0, 4.0};
+  std::cout << std::setw(60) << "median of 1, 2, 3, 4" << std::setw(10) << Statistics::getPercentile(values, 0.5)
+            << std::endl;
+
+  std::cout << std::endl;
+
+  std::cout << "Instrumentation of simultaneous preaccumulations." << std::endl;
+  auto data = benchmark.run<Strategy::RADIX_SORT_EDITING>(preaccs);
+  Instrumentation::print(std::cout, data.threadTimes, nRuns);
 
   return 0;
 }
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "tape.hpp"
+
+/** @brief Binary trace of preaccumulation work items, e.g., captured from production AD runs.
+ *
+ *  Layout, in native byte order:
+ *  - Header
+ *  - per work item: its identifiers, padded to recordAlignment, followed by its Jacobians, padded to recordAlignment
+ *  - index: per work item an IndexEntry with the byte offset of its record, its tape size and its number of
+ *    evaluations
+ *
+ *  Records can be written one at a time, the header is completed once the index has been written. Replay maps the file
+ *  and evaluates the records in place.
+ */
+namespace Trace {
+
+  uint32_t const version = 1;
+  size_t const recordAlignment = 64;
+
+  struct Header {
+    public:
+      char magic[8];            /// "LADTRACE"
+      uint32_t version;
+      uint32_t identifierSize;  /// sizeof(Identifier) of the recorded tapes
+      uint32_t gradientSize;    /// sizeof(Gradient) of the recorded tapes
+      uint32_t reserved;
+      uint64_t nItems;
+      uint64_t indexOffset;     /// byte offset of the index, 0 while recording
+  };
+
+  struct IndexEntry {
+    public:
+      uint64_t offset;  /// byte offset of the identifiers of the work item
+      uint64_t size;    /// tape size
+      uint64_t nEvals;  /// number of evaluations
+  };
+
+  inline void setMagic(Header& header) {
+    std::memcpy(header.magic, "LADTRACE", sizeof(header.magic));
+  }
+
+  inline size_t getPadding(size_t bytes) {
+    return (recordAlignment - bytes % recordAlignment) % recordAlignment;
+  }
+
+  /// Writes work items to a trace file one at a time.
+  template<typename Identifier, typename Gradient>
+  struct Recorder {
+    public:
+      std::ofstream file;
+      std::vector<IndexEntry> index;
+      uint64_t position;  /// current byte offset in the file
+
+      /// Create or truncate the given file. Throws std::runtime_error on failure.
+      explicit Recorder(std::string const& path)
+          : file(path, std::ios::binary | std::ios::trunc), index(), position(0) {
+        if (!file) {
+          throw std::runtime_error("Cannot open trace " + path + " for writing.");
+        }
+        Header header = getHeader(0);
+        write(&header, sizeof(header));
+      }
+
+      ~Recorder() {
+        if (file.is_open()) {
+          file.close();
+        }
+      }
+
+      /// Append a work item with the given tape, evaluated nEvals times. Throws std::invalid_argument for an empty
+      /// tape or no evaluations, which replay rejects.
+      template<typename TapeType>
+      void record(TapeType const& tape, size_t nEvals) {
+        record(tape.identifiers.data(), tape.jacobians.data(), tape.identifiers.size(), nEvals);
+      }
+
+      void record(Identifier const* identifiers, Gradient const* jacobians, size_t size, size_t nEvals) {
+        if (size == 0 || nEvals == 0) {
+          throw std::invalid_argument("Work items of a trace need a nonempty tape and at least one evaluation.");
+        }
+        index.push_back(IndexEntry{position, size, nEvals});
+        write(identifiers, size * sizeof(Identifier));
+        write(jacobians, size * sizeof(Gradient));
+      }
+
+      /// Write the index and complete the header. Throws std::runtime_error on failure.
+      void close() {
+        uint64_t indexOffset = position;
+        write(index.data(), index.size() * sizeof(IndexEntry));
+
+        Header header = getHeader(indexOffset);
+        file.seekp(0);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        file.close();
+        if (!file) {
+          throw std::runtime_error("Cannot write trace.");
+        }
+      }
+
+    private:
+      Header getHeader(uint64_t indexOffset) const {
+        Header header;
+        std::memset(&header, 0, sizeof(header));
+        setMagic(header);
+        header.version = version;
+        header.identifierSize = sizeof(Identifier);
+        header.gradientSize = sizeof(Gradient);
+        header.nItems = index.size();
+        header.indexOffset = indexOffset;
+        return header;
+      }
+
+      /// Write the given data followed by padding to the record alignment.
+      void write(void const* data, size_t bytes) {
+        static char const zeros[recordAlignment] = {};
+        file.write(static_cast<char const*>(data), bytes);
+        file.write(zeros, getPadding(bytes));
+        position += bytes + getPadding(bytes);
+        if (!file) {
+          throw std::runtime_error("Cannot write trace.");
+        }
+      }
+  };
+
+  /// Private mapping of a trace file, unmapped once the last copy is destructed.
+  struct Mapping {
+    public:
+      char* data;
+      size_t length;
+
+      Mapping(char* data, size_t length) : data(data), length(length) {}
+
+      Mapping(Mapping const&) = delete;
+
+      ~Mapping() {
+        munmap(data, length);
+      }
+  };
+
+  /** @brief Read-only replay of a trace file, whose work items are evaluated in place.
+   *
+   *  The file is mapped privately, so that in-place remapping of identifiers does not modify the file. In streaming
+   *  mode, the kernel is asked to read ahead the next work item and to drop the pages of processed work items, so that
+   *  traces larger than the main memory can be replayed.
+   */
+  template<typename Identifier, typename Gradient>
+  struct MappedTrace {
+    public:
+      std::shared_ptr<Mapping> mapping;
+      IndexEntry const* index;
+      size_t nItems;
+      bool streaming;
+      std::vector<char> remapped;  /// per work item, whether its identifiers have been remapped in place
+
+      MappedTrace() : mapping(), index(nullptr), nItems(0), streaming(false), remapped() {}
+
+      /// Map the given trace. Throws std::runtime_error if it cannot be read or does not match the types.
+      void open(std::string const& path, bool streaming) {
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) {
+          throw std::runtime_error("Cannot open trace " + path + ".");
+        }
+        struct stat status;
+        if (fstat(descriptor, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(Header)) {
+          ::close(descriptor);
+          throw std::runtime_error("Trace " + path + " is too short.");
+        }
+        size_t length = status.st_size;
+        void* data = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+        ::close(descriptor);
+        if (data == MAP_FAILED) {
+          throw std::runtime_error("Cannot map trace " + path + ".");
+        }
+        mapping = std::make_shared<Mapping>(static_cast<char*>(data), length);
+
+        Header const& header = *reinterpret_cast<Header const*>(mapping->data);
+        Header expected;
+        setMagic(expected);
+        if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != version ||
+            header.indexOffset == 0 || header.indexOffset % recordAlignment != 0 || header.indexOffset > length ||
+            header.nItems > (length - header.indexOffset) / sizeof(IndexEntry)) {
+          mapping.reset();
+          throw std::runtime_error("Trace " + path + " is invalid or incomplete.");
+        }
+        if (header.identifierSize != sizeof(Identifier) || header.gradientSize != sizeof(Gradient)) {
+          mapping.reset();
+          throw std::runtime_error("Trace " + path + " was recorded with different identifier or gradient types.");
+        }
+
+        index = reinterpret_cast<IndexEntry const*>(mapping->data + header.indexOffset);
+        for (size_t i = 0; i < header.nItems; ++i) {
+          if (!isValid(index[i], header.indexOffset)) {
+            mapping.reset();
+            index = nullptr;
+            throw std::runtime_error("Trace " + path + " is invalid or incomplete.");
+          }
+        }
+        nItems = header.nItems;
+        this->streaming = streaming;
+        remapped.assign(nItems, false);
+
+        madvise(mapping->data, length, streaming ? MADV_SEQUENTIAL : MADV_NORMAL);
+      }
+
+      size_t size() const {
+        return nItems;
+      }
+
+      size_t getTapeSize(size_t i) const {
+        return index[i].size;
+      }
+
+      size_t getNumberOfEvaluations(size_t i) const {
+        return index[i].nEvals;
+      }
+
+      /// View of the tape of work item i, evaluated in place.
+      TapeView<Identifier, Gradient> getTape(size_t i) {
+        char* record = mapping->data + index[i].offset;
+        size_t identifierBytes = index[i].size * sizeof(Identifier);
+        return TapeView<Identifier, Gradient>(
+            reinterpret_cast<Identifier*>(record),
+            reinterpret_cast<Gradient*>(record + identifierBytes + getPadding(identifierBytes)), index[i].size,
+            remapped[i]);
+      }
+
+      /// In streaming mode, start reading work item i ahead.
+      void willNeed(size_t i) const {
+        if (streaming && i < nItems) {
+          advise(i, MADV_WILLNEED);
+        }
+      }
+
+      /// In streaming mode, drop the pages of work item i. Work items are not edited in place in streaming mode, so
+      /// that dropped pages are read again from the file.
+      void dontNeed(size_t i) const {
+        if (streaming) {
+          advise(i, MADV_DONTNEED);
+        }
+      }
+
+    private:
+      /// Bytes of the identifiers, their padding and the Jacobians of a record with the given tape size.
+      static size_t getRecordBytes(size_t size) {
+        size_t identifierBytes = size * sizeof(Identifier);
+        return identifierBytes + getPadding(identifierBytes) + size * sizeof(Gradient);
+      }
+
+      /// Whether the entry has a nonempty tape and at least one evaluation, and its record is aligned, follows the
+      /// header and ends before the index.
+      static bool isValid(IndexEntry const& entry, uint64_t indexOffset) {
+        if (entry.size == 0 || entry.nEvals == 0) {
+          return false;
+        }
+        if (entry.offset < sizeof(Header) || entry.offset % recordAlignment != 0 || entry.offset > indexOffset) {
+          return false;
+        }
+        uint64_t available = indexOffset - entry.offset;
+        return entry.size <= available / (sizeof(Identifier) + sizeof(Gradient)) &&
+               getRecordBytes(entry.size) <= available;
+      }
+
+      /// Advise the pages of work item i. WILLNEED covers all pages that the record touches, DONTNEED only pages that
+      /// lie entirely within the record, as pages shared with neighbouring work items would be read again.
+      void advise(size_t i, int advice) const {
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t begin = index[i].offset;
+        size_t end = begin + getRecordBytes(index[i].size);
+        if (advice == MADV_DONTNEED) {
+          begin = (begin + pageSize - 1) / pageSize * pageSize;
+          end = end / pageSize * pageSize;
+        } else {
+          begin = begin / pageSize * pageSize;
+          end = std::min((end + pageSize - 1) / pageSize * pageSize, mapping->length);
+        }
+        if (begin < end) {
+          madvise(mapping->data + begin, end - begin, advice);
+        }
+      }
+  };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <vector>
+
+#include "tape.hpp"
+
+/** @brief Preaccumulation workload that is generated once and stored in contiguous memory.
+ *
+ *  The tape of work item i occupies the positions offsets[i] to offsets[i + 1] - 1 of identifiers and jacobians and is
+ *  evaluated nEvals[i] times.
+ */
+template<typename Identifier, typename Gradient>
+struct Workload {
+  public:
+    std::vector<Identifier> identifiers;  /// identifiers of all tapes
+    std::vector<Gradient> jacobians;      /// Jacobians of all tapes
+    std::vector<size_t> offsets;          /// start of each tape, followed by the total size
+    std::vector<size_t> nEvals;           /// number of evaluations per work item
+    std::vector<char> remapped;           /// per work item, whether its identifiers have been remapped in place
+
+    size_t size() const {
+      return nEvals.size();
+    }
+
+    size_t getTapeSize(size_t i) const {
+      return offsets[i + 1] - offsets[i];
+    }
+
+    size_t getNumberOfEvaluations(size_t i) const {
+      return nEvals[i];
+    }
+
+    /// Allocate memory for work items with the given tape sizes and numbers of evaluations.
+    void resize(std::vector<size_t> const& sizes, std::vector<size_t> const& nEvals) {
+      this->nEvals = nEvals;
+      remapped.assign(sizes.size(), false);
+
+      offsets.resize(sizes.size() + 1);
+      offsets[0] = 0;
+      for (size_t i = 0; i < sizes.size(); ++i) {
+        offsets[i + 1] = offsets[i] + sizes[i];
+      }
+
+      identifiers.resize(offsets.back());
+      jacobians.resize(offsets.back());
+    }
+
+    /// View of the tape of work item i, evaluated in place.
+    TapeView<Identifier, Gradient> getTape(size_t i) {
+      return TapeView<Identifier, Gradient>(identifiers.data() + offsets[i], jacobians.data() + offsets[i],
+                                            offsets[i + 1] - offsets[i], remapped[i]);
+    }
+
+    /// Release the memory of the workload.
+    void clear() {
+      *this = Workload();
+    }
+};